@@ -0,0 +1,56 @@
+#include "apa102.h"
+#include "pixel_ops.h"
+#include "output_lut.h"
+#include "output_driver.h"
+#include "pixel_arena.h"
+
+extern DotStarStrip strip;
+
+// 31 * 255 * 65536 / 65535 / level in 25.7 fixed point, the PWM value is (value * scale) >> 23,
+// which does not overflow because the brightest color is at most level * 65535 / 31
+static const uint32_t levelScale[APA102_LEVELS + 1] = {
+        0, 1011855,  505928,  337285,  252964,  202371,  168643,  144551,
+   126482,  112428,  101186,   91987,   84321,   77835,   72275,   67457,
+    63241,   59521,   56214,   53256,   50593,   48184,   45993,   43994,
+    42161,   40474,   38918,   37476,   36138,   34892,   33729,   32640,
+};
+
+void apa102Encode(uint16_t r, uint16_t g, uint16_t b, uint8_t *frame) {
+  uint32_t m = max(r, max(g, b));
+  uint32_t level = (m * APA102_LEVELS + 65534) / 65535;
+  if (level == 0)
+    level = 1;
+  uint32_t scale = levelScale[level];
+  frame[0] = 0xE0 | level;
+  frame[R_OFFSET] = (r * scale + (1 << 22)) >> 23;
+  frame[G_OFFSET] = (g * scale + (1 << 22)) >> 23;
+  frame[B_OFFSET] = (b * scale + (1 << 22)) >> 23;
+}
+
+uint16_t apa102Decode(const uint8_t *frame, uint8_t offset) {
+  uint32_t level = frame[0] & 0x1F;
+  return (uint32_t)frame[offset] * level * 65535 / (APA102_LEVELS * 255);
+}
+
+static uint16_t *hdr = arena.hdr;
+static uint16_t hdrCount = 0;
+
+uint16_t *hdrPixels(void) {
+  arenaClaim(ARENA_HDR);
+  hdrCount = strip.numPixels();
+  return hdr;
+}
+
+void hdrShow(void) {
+  uint16_t n = hdrCount;
+  uint8_t *frames = outputFrames(n);
+  if (!frames)
+    return;
+
+  lutApply16(hdr, n);
+  const uint16_t *p = hdr;
+  for (uint16_t pixel = 0; pixel < n; pixel++, p += 3, frames += PIXEL_BYTES)
+    apa102Encode(p[0], p[1], p[2], frames);
+  outputSend();
+  showTransfers++;
+}
@@ -0,0 +1,30 @@
+#ifndef _APA102_H_
+#define _APA102_H_
+
+#include <Arduino.h>
+
+/*
+  High dynamic range output for APA102 pixels. Every LED frame starts with a
+  5-bit global brightness that the DotStar library always sets to full. Here
+  16-bit linear colors are split into the smallest brightness level that
+  still fits the brightest color, and 8-bit PWM values relative to that level.
+  Dim colors keep up to 5 extra bits of resolution, a frame is still four
+  bytes per pixel.
+*/
+
+#define APA102_LEVELS 31
+
+// the LED frame for one pixel: 0xE0 | level, then the PWM values in the order of STRIP_ORDER
+void apa102Encode(uint16_t r, uint16_t g, uint16_t b, uint8_t *frame);
+
+// the 16-bit value that an LED frame represents for the color at offset 1-3, for the checks
+uint16_t apa102Decode(const uint8_t *frame, uint8_t offset);
+
+// 16-bit pixels, three values per pixel in r, g, b order, as many as the strip has, from the pixel arena
+uint16_t *hdrPixels(void);
+
+// correct the 16-bit pixels with the output tables and send them, see output_lut.h and output_driver.h,
+// unlike showPixels() an unchanged frame is transmitted again
+void hdrShow(void);
+
+#endif
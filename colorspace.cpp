@@ -1,103 +1,75 @@
 #include "colorspace.h"
 
-hsv rgb2hsv(rgb in)
-{
-  hsv         out;
-  double      min, max, delta;
+// x / 255 without a division, exact for 0 <= x < 65535
+#define DIV255(x) (((x) + 1 + ((x) >> 8)) >> 8)
 
-  min = in.r < in.g ? in.r : in.g;
-  min = min  < in.b ? min  : in.b;
+// which of v, p, q and t goes to red, green and blue in each of the six hue sectors
+static const uint8_t sector[6][3] = {
+  { 0, 3, 1 },    // v t p
+  { 2, 0, 1 },    // q v p
+  { 1, 0, 3 },    // p v t
+  { 1, 2, 0 },    // p q v
+  { 3, 1, 0 },    // t p v
+  { 0, 1, 2 },    // v p q
+};
 
-  max = in.r > in.g ? in.r : in.g;
-  max = max  > in.b ? max  : in.b;
+void hsv2rgb16(uint16_t h, uint8_t s, uint8_t v, uint8_t *r, uint8_t *g, uint8_t *b)
+{
+  uint32_t    hh, ff, vs;
+  uint8_t     c[4];
+  const uint8_t *m;
 
-  out.v = max;                              // v
-  delta = max - min;
-  if (delta < 0.00001)
-  {
-    out.s = 0;
-    out.h = 0; // undefined, maybe nan?
-    return out;
+  if (s == 0) {
+    *r = v;
+    *g = v;
+    *b = v;
+    return;
   }
-  if ( max > 0.0 ) { // NOTE: if Max is == 0, this divide would cause a crash
-    out.s = (delta / max);                  // s
-  } else {
-    // if max is 0, then r = g = b = 0
-    // s = 0, v is undefined
-    out.s = 0.0;
-    out.h = 0. / 0.;                        // its now undefined
-    return out;
-  }
-  if ( in.r >= max )                        // > is bogus, just keeps compilor happy
-    out.h = ( in.g - in.b ) / delta;        // between yellow & magenta
-  else if ( in.g >= max )
-    out.h = 2.0 + ( in.b - in.r ) / delta;  // between cyan & yellow
-  else
-    out.h = 4.0 + ( in.r - in.g ) / delta;  // between magenta & cyan
 
-  out.h *= 60.0;                            // degrees
+  hh = (uint32_t)h * 6;                     // sector in the upper 16 bits
+  ff = hh & 0xFFFF;                         // position within the sector
+  vs = (uint32_t)v * s;
 
-  if ( out.h < 0.0 )
-    out.h += 360.0;
+  c[0] = v;
+  c[1] = DIV255((uint32_t)v * (255 - s));                                       // p
+  c[2] = DIV255(((uint32_t)v * 255 * 65536 - vs * ff) >> 16);                   // q
+  c[3] = DIV255(((uint32_t)v * 255 * 65536 - vs * (65536 - ff)) >> 16);         // t
 
-  return out;
+  m  = sector[hh >> 16];
+  *r = c[m[0]];
+  *g = c[m[1]];
+  *b = c[m[2]];
 }
 
-
-rgb hsv2rgb(hsv in)
+void rgb2hsv16(uint8_t r, uint8_t g, uint8_t b, uint16_t *h, uint8_t *s, uint8_t *v)
 {
-  double      hh, p, q, t, ff;
-  long        i;
-  rgb         out;
+  uint8_t     min, max, delta;
+  int32_t     hh;
 
-  if (in.s <= 0.0) {      // < is bogus, just shuts up warnings
-    out.r = in.v;
-    out.g = in.v;
-    out.b = in.v;
-    return out;
-  }
-  hh = in.h;
-  if (hh >= 360.0) hh = 0.0;
-  hh /= 60.0;
-  i = (long)hh;
-  ff = hh - i;
-  p = in.v * (1.0 - in.s);
-  q = in.v * (1.0 - (in.s * ff));
-  t = in.v * (1.0 - (in.s * (1.0 - ff)));
+  min = r < g ? r : g;
+  min = min < b ? min : b;
 
-  switch (i) {
-    case 0:
-      out.r = in.v;
-      out.g = t;
-      out.b = p;
-      break;
-    case 1:
-      out.r = q;
-      out.g = in.v;
-      out.b = p;
-      break;
-    case 2:
-      out.r = p;
-      out.g = in.v;
-      out.b = t;
-      break;
+  max = r > g ? r : g;
+  max = max > b ? max : b;
 
-    case 3:
-      out.r = p;
-      out.g = q;
-      out.b = in.v;
-      break;
-    case 4:
-      out.r = t;
-      out.g = p;
-      out.b = in.v;
-      break;
-    case 5:
-    default:
-      out.r = in.v;
-      out.g = p;
-      out.b = q;
-      break;
+  *v = max;                                 // v
+  delta = max - min;
+  if (delta == 0) {
+    *s = 0;
+    *h = 0;                                 // undefined
+    return;
   }
-  return out;
+  *s = (uint16_t)delta * 255 / max;         // s
+
+  if (r == max)
+    hh = 0 * 65536 + ((int32_t)(g - b) << 16) / delta;   // between yellow & magenta
+  else if (g == max)
+    hh = 2 * 65536 + ((int32_t)(b - r) << 16) / delta;   // between cyan & yellow
+  else
+    hh = 4 * 65536 + ((int32_t)(r - g) << 16) / delta;   // between magenta & cyan
+
+  if (hh < 0)
+    hh += 6 * 65536;
+
+  *h = hh / 6;                              // 65536 per full turn
 }
@@ -1,20 +1,24 @@
 #ifndef _COLORSPACE_H_
 #define _COLORSPACE_H_
 
-typedef struct {
-    double r;       // percent
-    double g;       // percent
-    double b;       // percent
-} rgb;
+#include <stdint.h>
 
-typedef struct {
-    double h;       // angle in degrees
-    double s;       // percent
-    double v;       // percent
-} hsv;
+/*
+  Integer HSV conversions. Saturation, value and the color channels are 0-255,
+  the hue spans a full turn of 360 degrees either as 0-255 or as 0-65535.
+*/
 
-hsv rgb2hsv(rgb);
-rgb hsv2rgb(hsv);
+void hsv2rgb16(uint16_t h, uint8_t s, uint8_t v, uint8_t *r, uint8_t *g, uint8_t *b);
+void rgb2hsv16(uint8_t r, uint8_t g, uint8_t b, uint16_t *h, uint8_t *s, uint8_t *v);
 
-#endif
+static inline void hsv2rgb8(uint8_t h, uint8_t s, uint8_t v, uint8_t *r, uint8_t *g, uint8_t *b) {
+  hsv2rgb16((uint16_t)h << 8, s, v, r, g, b);
+}
+
+static inline void rgb2hsv8(uint8_t r, uint8_t g, uint8_t b, uint8_t *h, uint8_t *s, uint8_t *v) {
+  uint16_t hh;
+  rgb2hsv16(r, g, b, &hh, s, v);
+  *h = (hh + 128) >> 8;
+}
 
+#endif
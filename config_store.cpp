@@ -0,0 +1,119 @@
+#include <FS.h>
+
+#include "config_store.h"
+#include "log.h"
+
+static_assert(sizeof(Config) <= 255, "Config does not fit the length in ConfigHeader");
+
+static const char *slots[2] = { "/config.a", "/config.b" };
+
+// the record that is on flash, the next one goes to the other slot
+static Config current;
+static int8_t currentSlot = -1;
+static uint32_t currentSequence = 0;
+
+uint32_t configWrites = 0;
+
+uint32_t configCrc(const uint8_t *data, size_t length) {
+  uint32_t crc = 0xFFFFFFFF;
+  while (length--) {
+    crc ^= *data++;
+    for (uint8_t bit = 0; bit < 8; bit++)
+      crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+  }
+  return ~crc;
+}
+
+// read one slot, the fields of config that are in the record are overwritten
+static bool readSlot(uint8_t slot, Config *config, uint32_t *sequence) {
+  uint8_t buf[sizeof(ConfigHeader) + 255 + 4];
+  File f = SPIFFS.open(slots[slot], "r");
+  if (!f)
+    return false;
+  size_t size = f.read(buf, sizeof(buf));
+  f.close();
+
+  const ConfigHeader *header = (const ConfigHeader *)buf;
+  if (size < sizeof(ConfigHeader) || header->magic != CONFIG_MAGIC || size != sizeof(ConfigHeader) + header->length + 4) {
+    LOG_W(LOG_CONFIG, "%s is not a config record", slots[slot]);
+    return false;
+  }
+  uint32_t crc;
+  memcpy(&crc, buf + size - 4, 4);
+  if (crc != configCrc(buf, size - 4)) {
+    LOG_W(LOG_CONFIG, "%s has a bad CRC", slots[slot]);
+    return false;
+  }
+  // an older firmware wrote fewer fields, a newer one more, the same version exactly these
+  int older = (header->version < CONFIG_VERSION) - (header->version > CONFIG_VERSION);
+  int shorter = (header->length < sizeof(Config)) - (header->length > sizeof(Config));
+  if (older != shorter) {
+    LOG_W(LOG_CONFIG, "%s has version %u with %u bytes", slots[slot], header->version, header->length);
+    return false;
+  }
+  memcpy(config, buf + sizeof(ConfigHeader), min((size_t)header->length, sizeof(Config)));
+  *sequence = header->sequence;
+  return true;
+}
+
+bool configLoad(Config *config) {
+  Config record[2];
+  uint32_t sequence[2];
+  bool valid[2];
+  for (uint8_t slot = 0; slot < 2; slot++) {
+    record[slot] = *config;
+    valid[slot] = readSlot(slot, &record[slot], &sequence[slot]);
+  }
+  if (!valid[0] && !valid[1])
+    return false;
+
+  // the newer of the two, the sequence number may have wrapped around
+  uint8_t slot = (valid[0] && (!valid[1] || (int32_t)(sequence[0] - sequence[1]) > 0)) ? 0 : 1;
+  *config = record[slot];
+  current = record[slot];
+  currentSlot = slot;
+  currentSequence = sequence[slot];
+  LOG_I(LOG_CONFIG, "config %u from %s", (unsigned)currentSequence, slots[slot]);
+  return true;
+}
+
+bool configStore(const Config *config) {
+  if (currentSlot >= 0 && !memcmp(&current, config, sizeof(Config)))
+    return true;
+
+  uint8_t buf[sizeof(ConfigHeader) + sizeof(Config) + 4];
+  ConfigHeader *header = (ConfigHeader *)buf;
+  header->magic = CONFIG_MAGIC;
+  header->version = CONFIG_VERSION;
+  header->length = sizeof(Config);
+  header->sequence = currentSequence + 1;
+  memcpy(buf + sizeof(ConfigHeader), config, sizeof(Config));
+  uint32_t crc = configCrc(buf, sizeof(buf) - 4);
+  memcpy(buf + sizeof(buf) - 4, &crc, 4);
+
+  uint8_t slot = (currentSlot == 0 ? 1 : 0);
+  File f = SPIFFS.open(slots[slot], "w");
+  if (!f) {
+    LOG_E(LOG_CONFIG, "Failed to open %s for writing", slots[slot]);
+    return false;
+  }
+  size_t written = f.write(buf, sizeof(buf));
+  f.close();
+  if (written != sizeof(buf)) {
+    LOG_E(LOG_CONFIG, "Failed to write %s", slots[slot]);
+    return false;
+  }
+  current = *config;
+  currentSlot = slot;
+  currentSequence = header->sequence;
+  configWrites++;
+  LOG_I(LOG_CONFIG, "config %u to %s", (unsigned)currentSequence, slots[slot]);
+  return true;
+}
+
+void configErase(void) {
+  SPIFFS.remove(slots[0]);
+  SPIFFS.remove(slots[1]);
+  currentSlot = -1;
+  currentSequence = 0;
+}
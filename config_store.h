@@ -0,0 +1,49 @@
+#ifndef _CONFIG_STORE_H_
+#define _CONFIG_STORE_H_
+
+#include <Arduino.h>
+#include "setup_ota.h"
+
+/*
+  The configuration is kept as a binary record in two SPIFFS files, A and
+  B, taking turns. Every record has a sequence number and a CRC-32, at boot
+  the newest record with a valid CRC wins. A write always goes to the slot
+  that does not hold the current record, so a power loss during a save
+  leaves the previous record intact, and the writes are spread over both
+  files.
+
+  configStore() only writes when the configuration differs from the
+  current record. Fields are only ever appended to Config, and
+  CONFIG_VERSION goes up with them: a record from an older firmware is
+  shorter, the fields it does not have keep the values they had before
+  configLoad(), i.e. the defaults. A record whose length does not agree
+  with its version is not used.
+
+  JSON is only used to import and export the configuration, see
+  loadConfig() and handleJSON().
+*/
+
+#define CONFIG_MAGIC   0x4643   // "CF"
+#define CONFIG_VERSION 1        // increase when a field is appended to Config
+
+struct __attribute__((packed)) ConfigHeader {
+  uint16_t magic;
+  uint8_t  version;
+  uint8_t  length;      // bytes of Config that follow, the CRC-32 comes after them
+  uint32_t sequence;    // the record with the higher number is newer
+};
+
+// the newest valid record, false if there is none
+bool configLoad(Config *config);
+
+// write the configuration if it changed, false if that failed
+bool configStore(const Config *config);
+
+// forget both records, e.g. to start over with the defaults
+void configErase(void);
+
+uint32_t configCrc(const uint8_t *data, size_t length);
+
+extern uint32_t configWrites;   // records written since the start
+
+#endif
@@ -0,0 +1,59 @@
+#include <SPI.h>
+
+#include "dotstar_strip.h"
+
+DotStarStrip::DotStarStrip(uint16_t n, uint8_t order, uint8_t *buffer, uint16_t capacity)
+  : numLEDs(0), maxLEDs(capacity), brightness(255), header(0xFF), pixels(buffer),
+    rOffset(1 + (order & 3)), gOffset(1 + ((order >> 2) & 3)), bOffset(1 + ((order >> 4) & 3)) {
+  updateLength(n);
+}
+
+void DotStarStrip::begin(void) {
+  SPI.begin();
+  SPI.setFrequency(STRIP_CLOCK);
+  SPI.setBitOrder(MSBFIRST);
+  SPI.setDataMode(SPI_MODE0);
+}
+
+// a new length clears the pixels, as with the library
+bool DotStarStrip::updateLength(uint16_t n) {
+  numLEDs = min(n, maxLEDs);
+  clear();
+  return numLEDs == n;
+}
+
+void DotStarStrip::clear(void) {
+  uint8_t *p = getPixels();
+  for (uint16_t i = 0; i < numLEDs; i++, p += PIXEL_BYTES) {
+    p[0] = header;
+    p[1] = p[2] = p[3] = 0;
+  }
+}
+
+void DotStarStrip::setPixelColor(uint16_t n, uint32_t c) {
+  setPixelColor(n, c >> 16, c >> 8, c);
+}
+
+void DotStarStrip::setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b) {
+  if (n >= numLEDs)
+    return;
+  uint8_t *p = getPixels() + PIXEL_BYTES * n;
+  p[rOffset] = r;
+  p[gOffset] = g;
+  p[bOffset] = b;
+}
+
+uint32_t DotStarStrip::getPixelColor(uint16_t n) const {
+  if (n >= numLEDs)
+    return 0;
+  const uint8_t *p = getPixels() + PIXEL_BYTES * n;
+  return Color(p[rOffset], p[gOffset], p[bOffset]);
+}
+
+void DotStarStrip::setBrightness(uint8_t b) {
+  brightness = b;
+  header = 0xE0 | ((b * 31 + 127) / 255);
+  uint8_t *p = getPixels();
+  for (uint16_t i = 0; i < numLEDs; i++, p += PIXEL_BYTES)
+    p[0] = header;
+}
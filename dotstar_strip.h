@@ -0,0 +1,69 @@
+#ifndef _DOTSTAR_STRIP_H_
+#define _DOTSTAR_STRIP_H_
+
+#include <Arduino.h>
+
+/*
+  APA102 strip with the pixel API of Adafruit_DotStar, but the buffer holds
+  the LED frames exactly as they go out on the wire, four bytes per pixel:
+  0xE0 | 5-bit brightness, then the three colors in the order of the strip.
+  The modes write the colors in place, so there is no encode pass between
+  the pixels and the output.
+
+  The buffer is given by the caller and holds PIXEL_BYTES for every pixel
+  of the largest strip, a new length never allocates. setBrightness() goes
+  into the 5-bit brightness of every LED frame, the fine brightness is in
+  the output tables, see output_lut.h.
+
+  There is no show(). showPixels() corrects the colors into the next frame
+  of the output driver, which adds the 4-byte start frame and the end frame
+  of 4 + count / 16 bytes of 0xFF, see output_driver.h.
+*/
+
+#define DOTSTAR_RGB (0 | (1 << 2) | (2 << 4))
+#define DOTSTAR_RBG (0 | (2 << 2) | (1 << 4))
+#define DOTSTAR_GRB (1 | (0 << 2) | (2 << 4))
+#define DOTSTAR_GBR (2 | (0 << 2) | (1 << 4))
+#define DOTSTAR_BRG (1 | (2 << 2) | (0 << 4))
+#define DOTSTAR_BGR (2 | (1 << 2) | (0 << 4))
+
+#define PIXEL_BYTES  4          // bytes per LED frame
+#define STRIP_CLOCK  8000000    // Hz on the SPI bus
+
+// start frame, LED frames and end frame of n pixels on the wire
+#define DOTSTAR_FRAME_BYTES(n) (4 + PIXEL_BYTES * (uint32_t)(n) + 4 + (n) / 16)
+
+class DotStarStrip {
+  public:
+    DotStarStrip(uint16_t n, uint8_t order, uint8_t *buffer, uint16_t capacity);
+
+    void begin(void);
+    // at most the capacity, returns false if n was cut off
+    bool updateLength(uint16_t n);
+    void clear(void);
+
+    void setPixelColor(uint16_t n, uint32_t c);
+    void setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b);
+    uint32_t getPixelColor(uint16_t n) const;
+
+    // 0-255, stored as the 5-bit brightness of the LED frames
+    void setBrightness(uint8_t b);
+    uint8_t getBrightness(void) const { return brightness; }
+
+    uint16_t numPixels(void) const { return numLEDs; }
+    uint8_t *getPixels(void) const { return pixels; }
+    uint16_t capacity(void) const { return maxLEDs; }
+
+    static uint32_t Color(uint8_t r, uint8_t g, uint8_t b) {
+      return ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+    }
+
+  private:
+    uint16_t numLEDs, maxLEDs;
+    uint8_t brightness;
+    uint8_t header;      // 0xE0 | 5-bit brightness
+    uint8_t *pixels;
+    uint8_t rOffset, gOffset, bOffset;
+};
+
+#endif
@@ -0,0 +1,245 @@
+#include <WiFiUdp.h>
+
+#include "e131_input.h"
+#include "e131_stats.h"
+#include "setup_ota.h"
+#include "mode_registry.h"
+
+extern Config config;
+
+// offsets in the E1.31 data packet, see ANSI E1.31-2016 table 4-1
+#define ACN_ID_ADDR        4
+#define ROOT_VECTOR_ADDR   18
+#define FRAME_VECTOR_ADDR  40
+#define SYNC_ADDR          109
+#define SEQUENCE_ADDR      111
+#define OPTIONS_ADDR       112
+#define UNIVERSE_ADDR      113
+#define DMP_VECTOR_ADDR    117
+#define COUNT_ADDR         123
+#define START_CODE_ADDR    125
+
+// offsets in the E1.31 synchronization packet, see table 4-2
+#define SYNC_SEQUENCE_ADDR 44
+#define SYNC_UNIVERSE_ADDR 45
+#define SYNC_PACKET_SIZE   49
+
+#define VECTOR_ROOT_E131_DATA     0x00000004
+#define VECTOR_ROOT_E131_EXTENDED 0x00000008
+#define VECTOR_E131_DATA_PACKET   0x00000002
+#define VECTOR_E131_EXTENDED_SYNCHRONIZATION 0x00000001
+#define VECTOR_DMP_SET_PROPERTY   0x02
+#define OPTION_PREVIEW_DATA       0x80
+
+#define GET16(p) (((uint16_t)(p)[0] << 8) | (p)[1])
+#define GET32(p) (((uint32_t)GET16(p) << 16) | GET16((p) + 2))
+
+static const uint8_t acnId[12] = { 0x41, 0x53, 0x43, 0x2d, 0x45, 0x31, 0x2e, 0x31, 0x37, 0x00, 0x00, 0x00 };
+
+static WiFiUDP udp;
+static uint8_t header[E131_HEADER_SIZE];
+static_assert(MAX_UNIVERSES <= 32, "the universes of a frame are kept in 32-bit masks");
+
+static uint8_t storage[INPUT_FRAMES][FRAME_SLOTS];
+static DmxFrame frames[INPUT_FRAMES] = {
+  { 0, 0, 0, 0, storage[0] },
+  { 0, 0, 0, 0, storage[1] },
+  { 0, 0, 0, 0, storage[2] },
+};
+static DmxFrame *front = &frames[0];
+static DmxFrame *back = &frames[1];
+static DmxFrame *previous = &frames[2];
+
+// where the slots of each universe go in the frame, rebuilt when the configuration changes
+static struct {
+  uint16_t start;
+  uint16_t count;
+} span[MAX_UNIVERSES];
+static int mapUniverse, mapUniverses, mapOffset, mapWidth;
+static uint16_t frameLength;
+
+static uint8_t sequence[MAX_UNIVERSES];
+static uint32_t seen;      // universes with a valid sequence number
+static uint32_t pending;   // universes already in the back frame
+static uint32_t complete;  // all universes of the frame
+
+// universe synchronization, see ANSI E1.31-2016 section 6.6
+static uint16_t syncAddress;   // as announced by the data packets, 0 if the source does not synchronize
+static uint8_t  syncSequence;
+static bool     syncSeen;      // a sync packet arrived within SYNC_TIMEOUT
+static uint32_t syncTime;      // millis() of the last sync packet
+
+static void buildMap(void) {
+  mapUniverse  = config.universe;
+  mapUniverses = config.universes;
+  mapOffset    = config.offset;
+  mapWidth     = modePixelChannels(config.mode);   // a pixel is not split over two universes
+
+  int universes = constrain(mapUniverses, 1, MAX_UNIVERSES);
+  int offset    = constrain(mapOffset, 0, DMX_SLOTS);
+  uint16_t start = 0;
+  for (int u = 0; u < universes; u++) {
+    int first = (u == 0 ? offset : 0);
+    span[u].start = start;
+    span[u].count = first + (DMX_SLOTS - first) / mapWidth * mapWidth;
+    start += span[u].count;
+  }
+  frameLength = start;
+  complete = (universes < 32 ? (1UL << universes) : 0UL) - 1;
+  seen = pending = 0;
+  syncSeen = false;
+  back->length = frameLength;
+  statsReset();
+}
+
+// rotate the frames, universes that did not arrive are carried over from the current frame
+static void publish(void) {
+  for (int u = 0; pending != complete; u++)
+    if (!(pending & (1UL << u))) {
+      memcpy(back->data + span[u].start, front->data + span[u].start, span[u].count);
+      if (front->length < span[u].start + span[u].count && front->length < back->length)
+        back->length = max(front->length, span[u].start);
+      pending |= (1UL << u);
+    }
+  back->universe = mapUniverse;
+  back->timestamp = millis();
+
+  DmxFrame *tmp = previous;
+  previous = front;
+  front = back;
+  back = tmp;
+  back->length = frameLength;
+  pending = 0;
+  statsFrame();
+}
+
+// complete frames are held for the sync packet, unless the sync packets stopped coming
+static bool synchronized(void) {
+  if (syncSeen && (millis() - syncTime) > SYNC_TIMEOUT)
+    syncSeen = false;
+  return syncAddress && syncSeen;
+}
+
+static bool receiveSync(void) {
+  if (GET32(header + FRAME_VECTOR_ADDR) != VECTOR_E131_EXTENDED_SYNCHRONIZATION)
+    return false;
+  if (!syncAddress || GET16(header + SYNC_UNIVERSE_ADDR) != syncAddress)
+    return false;
+
+  uint8_t seq = header[SYNC_SEQUENCE_ADDR];
+  int8_t step = seq - syncSequence;
+  if (syncSeen && step <= 0 && step > -20)
+    return false;
+  syncSequence = seq;
+  syncSeen = true;
+  syncTime = millis();
+
+  // latch whatever arrived since the previous sync
+  if (!pending)
+    return false;
+  publish();
+  return true;
+}
+
+static bool receiveData(int size) {
+  if (size < E131_HEADER_SIZE)
+    return false;
+  if (udp.read(header + SYNC_PACKET_SIZE, E131_HEADER_SIZE - SYNC_PACKET_SIZE) != E131_HEADER_SIZE - SYNC_PACKET_SIZE)
+    return false;
+  if (GET32(header + FRAME_VECTOR_ADDR) != VECTOR_E131_DATA_PACKET ||
+      header[DMP_VECTOR_ADDR] != VECTOR_DMP_SET_PROPERTY ||
+      header[START_CODE_ADDR] != 0)
+    return false;
+  if (header[OPTIONS_ADDR] & OPTION_PREVIEW_DATA)
+    return false;
+
+  uint16_t u = GET16(header + UNIVERSE_ADDR) - mapUniverse;
+  if (u >= MAX_UNIVERSES || !(complete & (1UL << u)))
+    return false;
+  uint32_t bit = 1UL << u;
+
+  // discard packets that arrive out of order, see ANSI E1.31-2016 section 6.7.2
+  uint8_t seq = header[SEQUENCE_ADDR];
+  int8_t step = seq - sequence[u];
+  statsPacket(u, step, !(seen & bit));
+  if ((seen & bit) && step <= 0 && step > -20)
+    return false;
+  sequence[u] = seq;
+  seen |= bit;
+
+  // the property value count includes the start code
+  uint16_t slots = GET16(header + COUNT_ADDR);
+  slots = (slots ? slots - 1 : 0);
+  if (slots > span[u].count)
+    slots = span[u].count;
+  if (slots > size - E131_HEADER_SIZE)
+    slots = size - E131_HEADER_SIZE;
+
+  // a universe that repeats before the frame is complete or synchronized means that a packet got lost
+  bool fresh = false;
+  if (pending & bit) {
+    publish();
+    fresh = true;
+  }
+
+  uint16_t n = udp.read(back->data + span[u].start, slots);
+  if (n < span[u].count && span[u].start + n < back->length)
+    back->length = span[u].start + n;
+  back->sequence = seq;
+  pending |= bit;
+
+  syncAddress = GET16(header + SYNC_ADDR);
+  if (pending == complete && !synchronized()) {
+    publish();
+    fresh = true;
+  }
+  return fresh;
+}
+
+void inputBegin(void) {
+  memset(storage, 0, sizeof(storage));
+  for (int i = 0; i < INPUT_FRAMES; i++)
+    frames[i].sequence = frames[i].timestamp = 0;
+  buildMap();
+  syncAddress = 0;
+  front->universe = previous->universe = config.universe;
+  front->length = previous->length = frameLength;
+  udp.begin(E131_PORT);
+}
+
+bool inputPoll(void) {
+  if (config.universe != mapUniverse || config.universes != mapUniverses || config.offset != mapOffset ||
+      modePixelChannels(config.mode) != mapWidth)
+    buildMap();
+
+  // fall back to free-run when the sync packets stop
+  if (pending == complete && !synchronized()) {
+    publish();
+    return true;
+  }
+
+  int size = udp.parsePacket();
+  if (size < SYNC_PACKET_SIZE)
+    return false;
+  if (udp.read(header, SYNC_PACKET_SIZE) != SYNC_PACKET_SIZE)
+    return false;
+  if (memcmp(header + ACN_ID_ADDR, acnId, sizeof(acnId)))
+    return false;
+
+  switch (GET32(header + ROOT_VECTOR_ADDR)) {
+    case VECTOR_ROOT_E131_DATA:
+      return receiveData(size);
+    case VECTOR_ROOT_E131_EXTENDED:
+      return receiveSync();
+    default:
+      return false;
+  }
+}
+
+const DmxFrame *inputFrame(void) {
+  return front;
+}
+
+const DmxFrame *inputPrevious(void) {
+  return previous;
+}
@@ -0,0 +1,60 @@
+#ifndef _E131_INPUT_H_
+#define _E131_INPUT_H_
+
+#include <Arduino.h>
+#include "pixel_arena.h"
+
+/*
+  E1.31 (sACN) receiver that reads the DMX slots of a packet straight from
+  the UDP socket into a back frame. Once it is complete the back frame
+  becomes the current one and the current one the previous, so the renderer
+  always sees two complete and stable frames and no bytes are copied in the
+  loop.
+
+  A frame spans config.universes consecutive universes starting at
+  config.universe. The slots of the first universe are stored as they are,
+  including the config.offset slots in front of the first pixel, and the
+  following universes are appended after the last whole pixel of the
+  previous one. The pixels of modes 0 and 13 are therefore contiguous in
+  data.
+
+  A frame has room for MAX_PIXELS of the widest pixel format, RGBW with 4
+  slots per pixel. The 16-bit pixels of mode 13 take twice as many, that
+  mode drives up to half of MAX_PIXELS.
+
+  When the source announces a sync address and sends synchronization
+  packets, a complete frame is held until the next sync packet. Without sync
+  packets for SYNC_TIMEOUT the frames are published as soon as they are
+  complete again.
+*/
+
+#define E131_PORT         5568
+#define E131_HEADER_SIZE  126   // everything up to and including the DMX start code
+#define DMX_SLOTS         512
+#define DMX_PIXEL_SLOTS   4     // RGBW
+#define MAX_UNIVERSES     ((MAX_PIXELS + DMX_SLOTS / DMX_PIXEL_SLOTS - 1) / (DMX_SLOTS / DMX_PIXEL_SLOTS))
+#define FRAME_SLOTS       (MAX_UNIVERSES * DMX_SLOTS)
+#define INPUT_FRAMES      3     // the current, the previous and the one being received
+#define SYNC_TIMEOUT      2500  // ms without sync packets before falling back to free-run
+
+struct DmxFrame {
+  uint16_t universe;    // first universe of the frame
+  uint16_t length;      // number of valid bytes in data
+  uint8_t  sequence;    // of the packet that completed the frame
+  uint32_t timestamp;   // millis() at arrival of that packet
+  uint8_t  *data;       // FRAME_SLOTS bytes in the input, fewer in a blended frame
+};
+
+// start listening, the initial frame is all zero
+void inputBegin(void);
+
+// receive at most one packet, returns true if it completed a new frame
+bool inputPoll(void);
+
+// the most recent frame, valid until the next call to inputPoll
+const DmxFrame *inputFrame(void);
+
+// the frame before that, for interpolation
+const DmxFrame *inputPrevious(void);
+
+#endif
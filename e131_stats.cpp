@@ -0,0 +1,100 @@
+#include "e131_stats.h"
+
+UniverseStats universeStats[MAX_UNIVERSES];
+uint32_t packetTotal = 0;
+uint32_t frameTotal = 0;
+
+static uint32_t frameArrival[STATS_RING];
+static uint8_t frameHead = 0, frameCount = 0;
+
+void statsReset(void) {
+  memset(universeStats, 0, sizeof(universeStats));
+  frameHead = frameCount = 0;
+}
+
+// add a timestamp to a ring
+static void record(uint32_t *ring, uint8_t *head, uint8_t *count, uint32_t now) {
+  ring[*head] = now;
+  *head = (*head + 1) % STATS_RING;
+  if (*count < STATS_RING)
+    (*count)++;
+}
+
+// events per second over the timestamps in a ring
+static float rate(const uint32_t *ring, uint8_t head, uint8_t count) {
+  if (count < 2)
+    return 0;
+  uint32_t newest = ring[(head + STATS_RING - 1) % STATS_RING];
+  uint32_t oldest = ring[(head + STATS_RING - count) % STATS_RING];
+  // no arrivals for a while means the stream stopped
+  uint32_t span = max(newest - oldest, (uint32_t)micros() - oldest);
+  return span ? (count - 1) * 1e6f / span : 0;
+}
+
+void statsPacket(uint8_t u, int8_t step, bool first) {
+  UniverseStats *s = &universeStats[u];
+  uint32_t now = micros();
+  packetTotal++;
+  s->packets++;
+
+  if (first || step <= -20)
+    ;                           // new or restarted source
+  else if (step == 0)
+    s->duplicates++;
+  else if (step < 0) {
+    s->reordered++;
+    if (s->lost)
+      s->lost--;
+  }
+  else
+    s->lost += step - 1;
+
+  if (s->count) {
+    int32_t interval = now - s->arrival[(s->head + STATS_RING - 1) % STATS_RING];
+    if (s->count == 1)
+      s->interval = interval;
+    uint32_t deviation = abs(interval - s->interval) / 1000;
+    int bin = 0;
+    while (deviation && bin < JITTER_BINS - 1) {
+      deviation >>= 1;
+      bin++;
+    }
+    s->jitter[bin]++;
+    s->interval += (interval - s->interval) / 16;
+  }
+  record(s->arrival, &s->head, &s->count, now);
+}
+
+void statsFrame(void) {
+  frameTotal++;
+  record(frameArrival, &frameHead, &frameCount, micros());
+}
+
+float statsPacketRate(uint8_t u) {
+  return rate(universeStats[u].arrival, universeStats[u].head, universeStats[u].count);
+}
+
+float statsFrameRate(void) {
+  return rate(frameArrival, frameHead, frameCount);
+}
+
+uint32_t statsLost(void) {
+  uint32_t n = 0;
+  for (int u = 0; u < MAX_UNIVERSES; u++)
+    n += universeStats[u].lost;
+  return n;
+}
+
+uint32_t statsDuplicates(void) {
+  uint32_t n = 0;
+  for (int u = 0; u < MAX_UNIVERSES; u++)
+    n += universeStats[u].duplicates;
+  return n;
+}
+
+uint32_t statsReordered(void) {
+  uint32_t n = 0;
+  for (int u = 0; u < MAX_UNIVERSES; u++)
+    n += universeStats[u].reordered;
+  return n;
+}
@@ -0,0 +1,58 @@
+#ifndef _E131_STATS_H_
+#define _E131_STATS_H_
+
+#include <Arduino.h>
+#include "e131_input.h"
+
+/*
+  Telemetry of the E1.31 stream, to diagnose WiFi congestion in the field.
+
+  For every universe of the frame the arrival times of the last STATS_RING
+  packets are kept in a ring, which gives the effective packet rate. The
+  deviation of each interval from the running mean interval goes into a
+  histogram with power of two bins: below 1 ms, below 2 ms, ... and the last
+  bin for everything from 64 ms up. The E1.31 sequence number tells lost,
+  duplicate and out of order packets apart. A packet that arrives late has
+  first been counted as lost, it is moved over to out of order.
+
+  Everything is static, nothing is allocated on the packet path.
+*/
+
+#define STATS_RING   32
+#define JITTER_BINS  8
+
+struct UniverseStats {
+  uint32_t packets;
+  uint32_t lost;
+  uint32_t duplicates;
+  uint32_t reordered;
+  int32_t  interval;               // running mean of the inter-arrival time, in us
+  uint32_t jitter[JITTER_BINS];
+  uint32_t arrival[STATS_RING];    // micros()
+  uint8_t  head;                   // next entry of arrival to be written
+  uint8_t  count;                  // valid entries in arrival
+};
+
+extern UniverseStats universeStats[MAX_UNIVERSES];
+extern uint32_t packetTotal;       // E1.31 packets for one of our universes
+extern uint32_t frameTotal;        // frames published
+
+// forget everything, e.g. when the universes change
+void statsReset(void);
+
+// a data packet for universe index u, step is the sequence number minus the previous one
+void statsPacket(uint8_t u, int8_t step, bool first);
+
+// a frame was published
+void statsFrame(void);
+
+// packets per second of universe index u and frames per second, over the last STATS_RING arrivals
+float statsPacketRate(uint8_t u);
+float statsFrameRate(void);
+
+// sums over all universes
+uint32_t statsLost(void);
+uint32_t statsDuplicates(void);
+uint32_t statsReordered(void);
+
+#endif
@@ -8,25 +8,30 @@
    SACNview can be used to test the module.
 
    This sketch receive a DMX universes via E1.31 to control a
-   strip of APA102 leds via Adafruit's DotStar library:
+   strip of APA102 leds on the hardware SPI bus, with a pixel buffer
+   in the wire format and the same API as Adafruit's DotStar library:
 
  */
 
 #include <ESP8266WiFi.h>                // https://github.com/esp8266/Arduino
-#include <E131.h>                       //  https://github.com/forkineye/E131
-#define UNIVERSE 1                      /* Universe to listen for */
-#define CHANNEL_START 1                 /* Channel to start listening at */
-E131 e131;                              // E131 instance
-
 #include <ESP8266WebServer.h>
 #include <ESP8266mDNS.h>
 
-#include <Adafruit_DotStar.h>   // https://github.com/adafruit/Adafruit_DotStar
-#include <SPI.h>         // COMMENT OUT THIS LINE FOR GEMMA OR TRINKET
+#include <SPI.h>
 #include <FS.h>
 
 #include "setup_ota.h"
 #include "neopixel_mode.h"
+#include "pixel_ops.h"
+#include "e131_input.h"
+#include "e131_stats.h"
+#include "interpolate.h"
+#include "mode_registry.h"
+#include "output_lut.h"
+#include "output_driver.h"
+#include "dotstar_strip.h"
+#include "pixel_arena.h"
+#include "log.h"
 
 #include "global.h"
 
@@ -35,13 +40,14 @@ ESP8266WebServer server(80);
 
 const char* host = "ARTNET";
 const char* version = __DATE__ " / " __TIME__;
-float temperature = 0, fps = 0;
+float temperature = 0;
 
 // Neopixel settings
 #define NUMPIXELS 144 // Number of LEDs in strip
-#define CLOCKPIN    SCK   // D5 - GPIO14  HSCLK - SPI bus with ID 1 = HSPI
-#define DATAPIN     MOSI  // D7 - GPIO13 HCS    - SPI bus with ID 1 = HSPI
-Adafruit_DotStar strip = Adafruit_DotStar(NUMPIXELS, DATAPIN, CLOCKPIN, DOTSTAR_BRG);
+// the strip is on the hardware SPI pins, the buffer holds the frame in the APA102 wire format
+//   clock  D5 - GPIO14  HSCLK - SPI bus with ID 1 = HSPI
+//   data   D7 - GPIO13  HMOSI - SPI bus with ID 1 = HSPI
+DotStarStrip strip = DotStarStrip(NUMPIXELS, STRIP_ORDER, arena.strip, MAX_PIXELS);
 
 uint32_t debug_timeout = millis();
 uint32_t debug2_timeout = millis();
@@ -49,47 +55,51 @@ uint32_t debug2_timeout = millis();
 
 // Artnet settings
 // ArtnetWifi artnet;
-unsigned int packetCounter = 0;
-
-// Global universe buffer
-struct {
-        uint16_t universe;
-        uint16_t length;
-        uint8_t sequence;
-        uint8_t *data;
-} global;
-
-// use an array of function pointers to jump to the desired mode
-void (*mode[])(uint16_t, uint16_t, uint8_t, uint8_t *) {
-        mode0, mode1, mode2, mode3, mode4, mode5, mode6, mode7, mode8, mode9, mode10, mode11, mode12, mode13, mode14, mode15, mode16
-};
 
 // keep the timing of the function calls
-long tic_loop = 0, tic_fps = 0, tic_packet = 0, tic_web = 0;
+long tic_config = 0, tic_fps = 0, tic_packet = 0;
+uint32_t tic_tick = 0, tickOverruns = 0, tic_web = 0;
+uint32_t webDelay = 0;   // us, the longest a render had to wait for the web server
 long frameCounter = 0;
+bool frameReady = true, fading = false;
+
+#define FRAME_PERIOD 10000   // us, animated modes are rendered at 100Hz
+#define WEB_BUDGET   3000    // us, the web server only gets the loop when the next tick is at least this far away
+#define WEB_DEFER    50000   // us, but it is never held off for longer than this
 
 #define WIFI_CONNECT_TIMEOUT 10000
 // ------------------------------------------------------------------------------------- WiFiConnect
 // Wifi Connection
 void WifiConnect() {
 
-        DEBUGGING("--------------------------------------------------- WifiConnect ");
-        DEBUGGING_L(">> SSID: ");
-        DEBUGGING(WIFI_SSID);
+        LOG_I(LOG_WIFI, "WifiConnect to %s", WIFI_SSID);
 
-        /* Choose one to begin listening for E1.31 data */
-        e131.begin(WIFI_SSID, WIFI_PASS);                 /* via Unicast on the default port */
-        //e131.beginMulticast(ssid, passphrase, UNIVERSE);  /* via Multicast for Universe 1 */
+        WiFi.mode(WIFI_STA);
+        WiFi.begin(WIFI_SSID, WIFI_PASS);
+        uint32_t tic = millis();
+        while (WiFi.status() != WL_CONNECTED && (millis() - tic) < WIFI_CONNECT_TIMEOUT)
+                delay(100);
+        if (WiFi.status() != WL_CONNECTED)
+                LOG_W(LOG_WIFI, "not connected after %d ms", WIFI_CONNECT_TIMEOUT);
 
+        /* listen for E1.31 data via Unicast on the default port */
+        inputBegin();
 
 } // WifiConnect
 
 
 // ------------------------------------------------------------------------------------- updateNeopixelStrip
 void updateNeopixelStrip(void) {
-        // update the neopixel strip configuration
-        strip.updateLength(config.pixels);
-        strip.setBrightness(config.brightness);
+        // update the neopixel strip configuration, a new length clears the pixels but is never allocated,
+        // a longer strip is cut off at the size of the pixel arena
+        uint16_t pixels = constrain(config.pixels, 0, MAX_PIXELS);
+        if (strip.numPixels() != pixels)
+                strip.updateLength(pixels);
+        // the brightness is part of the output tables, the strip transmits the values as they are
+        strip.setBrightness(255);
+        lutBuild();
+        // the render kernels of the modes are specialized for the pixel format
+        modeSelect();
         /*
            if (config.leds == 3)
                 strip.updateType(NEO_GRB + NEO_KHZ800);
@@ -106,163 +116,164 @@ void setup() {
         while (!Serial) {
                 ;
         }
-        Serial.println("setup starting");
-
-        global.universe = 1;
-        global.sequence = 0;
-        global.length = 512;
-        global.data = (uint8_t *)malloc(512);
+        LOG_I(LOG_SETUP, "setup starting");
 
         SPIFFS.begin();
+        loadAssets();
         strip.begin();
+        outputBegin();
 
-        Serial.println("fullBlack");
+        LOG_D(LOG_SETUP, "fullBlack");
         fullBlack();
-        Serial.println("setPixelColor");
+        LOG_D(LOG_SETUP, "setPixelColor");
         strip.setPixelColor(0, strip.Color(100, 0, 0 ) );
-        Serial.println("show");
-        strip.show();
+        LOG_D(LOG_SETUP, "show");
+        // nothing polls the output driver during the delays, the frames are flushed here
+        showPixels();
+        outputFlush();
         delay(500);
         strip.setPixelColor(0, strip.Color(0, 100, 0 ) );
-        strip.show();
+        showPixels();
+        outputFlush();
         delay(500);
         strip.setPixelColor(0, strip.Color(0, 0, 100 ) );
-        strip.show();
+        showPixels();
+        outputFlush();
         delay(500);
         strip.setPixelColor(0, strip.Color(100, 100, 100 ) );
-        strip.show();
+        showPixels();
+        outputFlush();
 
         initialConfig();
 
         // saveConfig();
 
         if (loadConfig()) {
-                Serial.println("1 - updateNeopixelStrip");
+                LOG_D(LOG_SETUP, "1 - updateNeopixelStrip");
                 updateNeopixelStrip();
-                Serial.println("setBrightness");
+                LOG_D(LOG_SETUP, "setBrightness");
                 strip.setBrightness(255);
-                Serial.println("singleYellow");
+                LOG_D(LOG_SETUP, "singleYellow");
                 singleYellow();
+                outputFlush();
                 delay(1000);
         }
         else {
-                Serial.println("2 - updateNeopixelStrip");
+                LOG_D(LOG_SETUP, "2 - updateNeopixelStrip");
                 updateNeopixelStrip();
-                Serial.println("setBrightness");
+                LOG_D(LOG_SETUP, "setBrightness");
                 strip.setBrightness(255);
-                Serial.println("singleRed");
+                LOG_D(LOG_SETUP, "singleRed");
                 singleRed();
+                outputFlush();
                 delay(1000);
         }
 
         WifiConnect();
 
         // this serves all URIs that can be resolved to a file on the SPIFFS filesystem
-        Serial.println("server.onNotFound");
+        LOG_D(LOG_SETUP, "server.onNotFound");
         server.onNotFound(handleNotFound);
 
         server.on("/", HTTP_GET, []() {
-                tic_web = millis();
                 handleRedirect("/index");
         });
 
         server.on("/index", HTTP_GET, []() {
-                tic_web = millis();
                 handleStaticFile("/index.html");
         });
 
         server.on("/defaults", HTTP_GET, []() {
-                tic_web = millis();
-                Serial.println("handleDefaults");
+                LOG_I(LOG_WEB, "handleDefaults");
                 handleStaticFile("/reload_success.html");
                 delay(2000);
                 singleRed();
-                initialConfig();
-                saveConfig();
+                outputFlush();
+                defaultConfig();
+                logFlush();
                 ESP.restart();
         });
 
         server.on("/reconnect", HTTP_GET, []() {
-                tic_web = millis();
-                Serial.println("handleReconnect");
+                LOG_I(LOG_WEB, "handleReconnect");
                 handleStaticFile("/reload_success.html");
                 delay(2000);
                 singleYellow();
-                Serial.println("connected");
+                LOG_I(LOG_WIFI, "connected");
                 if (WiFi.status() == WL_CONNECTED)
                         singleGreen();
         });
 
         server.on("/reset", HTTP_GET, []() {
-                tic_web = millis();
-                Serial.println("handleReset");
+                LOG_I(LOG_WEB, "handleReset");
                 handleStaticFile("/reload_success.html");
                 delay(2000);
                 singleRed();
+                outputFlush();
+                logFlush();
                 ESP.restart();
         });
 
         server.on("/monitor", HTTP_GET, [] {
-                tic_web = millis();
                 handleStaticFile("/monitor.html");
         });
 
         server.on("/hello", HTTP_GET, [] {
-                tic_web = millis();
                 handleStaticFile("/hello.html");
         });
 
         server.on("/settings", HTTP_GET, [] {
-                tic_web = millis();
                 handleStaticFile("/settings.html");
         });
 
         server.on("/dir", HTTP_GET, [] {
-                tic_web = millis();
                 handleDirList();
         });
 
+        server.on("/modes", HTTP_GET, [] {
+                handleModes();
+        });
+
+        server.on("/stats", HTTP_GET, [] {
+                handleStats();
+        });
+
         server.on("/json", HTTP_PUT, [] {
-                tic_web = millis();
                 handleJSON();
         });
 
         server.on("/json", HTTP_POST, [] {
-                tic_web = millis();
                 handleJSON();
         });
 
         server.on("/json", HTTP_GET, [] {
-                tic_web = millis();
-                StaticJsonBuffer<300> jsonBuffer;
-                JsonObject& root = jsonBuffer.createObject();
-                CONFIG_TO_JSON(universe, "universe");
-                CONFIG_TO_JSON(offset, "offset");
-                CONFIG_TO_JSON(pixels, "pixels");
-                CONFIG_TO_JSON(leds, "leds");
-                CONFIG_TO_JSON(white, "white");
-                CONFIG_TO_JSON(brightness, "brightness");
-                CONFIG_TO_JSON(hsv, "hsv");
-                CONFIG_TO_JSON(mode, "mode");
-                CONFIG_TO_JSON(reverse, "reverse");
-                CONFIG_TO_JSON(speed, "speed");
-                CONFIG_TO_JSON(position, "position");
-                root["version"] = version;
-                root["uptime"]  = long(millis() / 1000);
-                root["packets"] = packetCounter;
-                root["fps"]     = fps;
-                String str;
-                root.printTo(str);
-                server.send(200, "application/json", str);
+                handleStatusJSON();
         });
 
+        server.on("/status.bin", HTTP_GET, [] {
+                handleStatusBin();
+        });
+
+        server.on("/config.json", HTTP_GET, [] {
+                handleConfigExport();
+        });
+
+#if LOG_LEVEL > LOG_OFF
+        server.on("/log", HTTP_GET, [] {
+                handleLog();
+        });
+#endif
+
         server.on("/update", HTTP_GET, [] {
-                tic_web = millis();
                 handleStaticFile("/update.html");
         });
 
         server.on("/update", HTTP_POST, handleUpdate1, handleUpdate2);
 
+        // the static files are answered from the cache of the browser and in gzip where possible
+        const char *headers[] = { "If-None-Match", "Accept-Encoding" };
+        server.collectHeaders(headers, 2);
+
         // start the web server
         server.begin();
 
@@ -274,14 +285,16 @@ void setup() {
         // artnet.setArtDmxCallback(onDmxPacket);
 
         // initialize all timers
-        tic_loop   = millis();
+        tic_config = millis();
+        tic_tick   = micros();
         tic_packet = millis();
         tic_fps    = millis();
-        tic_web    = 0;
+        tic_web    = micros();
 
         debug_timeout = millis();
         debug2_timeout = millis();
-        Serial.println("setup done");
+        LOG_I(LOG_SETUP, "setup done");
+        logFlush();
 } // setup
 
 // ------------------------------------------------------------------------------------- myDebug2
@@ -289,67 +302,93 @@ void myDebug_old(String strTopic) {
         static int i=0;
 
         if (millis() - debug_timeout > DEBUG_TIMEOUT ) {
-                Serial.print("DEBUG> ");
-                Serial.print(strTopic);
-                Serial.print(" ");
-                Serial.println(i++);
-
-                Serial.print("universe :");
-                Serial.println(global.universe);
-                Serial.print("length   :");
-                Serial.println(global.length);
-                Serial.print("sequence :");
-                Serial.println(global.sequence);
-                Serial.print("data     :");
-                Serial.print(global.data[0]);
-                Serial.print(" - ");
-                Serial.print(global.data[1]);
-                Serial.print(" - ");
-                Serial.println(global.data[2]);
+                const DmxFrame *frame = inputFrame();
+                LOG_D(LOG_SETUP, "%s %d universe %d length %d sequence %d data %d - %d - %d", strTopic.c_str(), i++,
+                      frame->universe, frame->length, frame->sequence, frame->data[0], frame->data[1], frame->data[2]);
 
                 debug_timeout = millis();
         }
 } // myDebug
 
-// ------------------------------------------------------------------------------------- loop
-void loop() {
+// ------------------------------------------------------------------------------------- webPoll
+// one turn of the web server, a render that became due while it ran is late by the rest of the request
+void webPoll() {
+        uint32_t start = micros();
         server.handleClient();
+        uint32_t end = micros();
+        uint32_t due = ((int32_t)(tic_tick - start) > 0 ? tic_tick : start);
+        if ((int32_t)(end - due) > (int32_t)webDelay)
+                webDelay = end - due;
+        tic_web = end;
+}
 
-        if (WiFi.status() != WL_CONNECTED) { // check if WiFi is conencted
-                singleRed();
-                // WifiConnect();
-        }
-        else if ((millis() - tic_web) < 5000) {
-                singleBlue();
+// ------------------------------------------------------------------------------------- loop
+void loop() {
+        // the frame on the wire gets the next chunk between the other jobs of the loop
+        outputPoll();
+
+        // the web server takes turns with the render, it waits while a frame is due
+        uint32_t now = micros();
+        if (!frameReady && ((int32_t)(tic_tick - now) >= WEB_BUDGET || (now - tic_web) >= WEB_DEFER)) {
+                webPoll();
+                heapSample();
+                outputPoll();
         }
-        else  {
-                // read e131 packet
-                if(e131.parsePacket()) {
-                        if (e131.universe == global.universe) {
-
-                                for (int i = 0; i < NUMPIXELS; i++) {
-                                        global.data[i] = e131.data[i];
-                                        //int j = i * 3 + (CHANNEL_START - 1);
-                                        //strip.setPixelColor(i, e131.data[j], e131.data[j+1], e131.data[j+2]);
-                                }
-                                // strip.show();
-                        }
-                }
 
-                // this section gets executed at a maximum rate of around 1Hz
-                if ((millis() - tic_loop) > 999)
+        // read e131 packets, the slots go straight into the next frame, stop as soon as one is complete
+        for (int i = 0; i < MAX_UNIVERSES && !frameReady; i++)
+                frameReady = inputPoll();
+        outputPoll();
+
+        // check for configuration changes once per second, the current frame is rendered again with them
+        if ((millis() - tic_config) > 999) {
+                static Config applied;
+                if (memcmp(&applied, &config, sizeof(Config))) {
                         updateNeopixelStrip();
+                        frameReady = true;
+                        applied = config;
+                }
+                tic_config = millis();
+        }
 
-                // this section gets executed at a maximum rate of around 100Hz
-                if ((millis() - tic_loop) > 9) {
-                        if (config.mode >= 0 && config.mode < (sizeof(mode) / 4)) {
-                                // call the function corresponding to the current mode
-                                (*mode[config.mode])(global.universe, global.length, global.sequence, global.data);
-                                tic_loop = millis();
+        // fixed period tick for the animated modes, missed ticks are skipped rather than rendered in a burst
+        bool tick = (int32_t)(micros() - tic_tick) >= 0;
+        if (tick) {
+                tic_tick += FRAME_PERIOD;
+                if ((int32_t)(micros() - tic_tick) >= 0) {
+                        tic_tick = micros() + FRAME_PERIOD;
+                        tickOverruns++;
+                }
+        }
+
+        if (WiFi.status() != WL_CONNECTED) { // check if WiFi is conencted
+                if (tick)
+                        singleRed();
+                // WifiConnect();
+        }
+        else {
+                // pass-through modes are rendered as soon as a new frame is complete, and on the tick while fading to it
+                bool animated = modeAnimated(config.mode);
+                if (animated ? tick : (frameReady || (fading && tick))) {
+                        const DmxFrame *frame = inputFrame();
+                        if (config.interpolate)
+                                frame = interpolateFrame(max(config.offset, 0) + modeFootprint(config.mode), &fading);
+                        // call the function corresponding to the current mode
+                        if (modeRender(config.mode, frame))
                                 frameCounter++;
-                        }
+                        frameReady = false;
+                        // the modes do not yield per pixel, once per frame is enough
+                        yield();
+                }
+                else if (tick && lutDithering() && !modeHdr(config.mode)) {
+                        // the dither only works while the frames keep coming
+                        showPixels();
                 }
         }
 
-        delay(1);
+        // the log goes to the serial port as far as it takes it without waiting, when no frame is due
+#if LOG_LEVEL > LOG_OFF
+        if (!frameReady && (int32_t)(tic_tick - micros()) >= WEB_BUDGET)
+                logDrain();
+#endif
 } // loop
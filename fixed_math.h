@@ -0,0 +1,67 @@
+#ifndef _FIXED_MATH_H_
+#define _FIXED_MATH_H_
+
+#include <Arduino.h>
+
+/*
+  Integer replacements for the float phase and geometry math of the modes,
+  the ESP8266 has no FPU.
+
+  angles      uint32_t with 65536 units per full turn, i.e. the lower 16 bits
+              hold the angle modulo 360 degrees and a cast to int16_t wraps
+              it between -180 and 180 degrees
+  fractions   q16_t, unsigned 16.16 fixed point where Q16_ONE is 1.0
+*/
+
+typedef uint32_t q16_t;
+
+#define Q16_ONE        65536UL
+#define ANGLE_360      65536UL
+#define ANGLE_180      32768UL
+
+// DMX value 0-255 to a fraction 0-1 or an angle 0-360 degrees, 255 maps exactly on 1 and 360
+static inline uint32_t qdmx(uint8_t x) {
+  return (uint32_t)x * 257 + (x >> 7);
+}
+
+#define DMX_TO_Q16(x)    qdmx(x)
+#define DMX_TO_ANGLE(x)  qdmx(x)
+
+#define AWRAP360(x)      ((uint16_t)(x))                                     // between    0 and 360
+#define AWRAP180(x)      ((int16_t)(x))                                      // between -180 and 180
+#define AABS(x)          ((uint32_t)(AWRAP180(x) < 0 ? -AWRAP180(x) : AWRAP180(x)))  // between 0 and 180
+
+// scale a color value with a fraction, truncating like the float code did
+#define QSCALE(x, l)     ((uint32_t)(x) * (l) >> 16)
+
+// color value scaled with a fraction, kept with 8 fractional bits for QMIX
+#define QSCALE8(x, l)    ((uint32_t)(x) * (l) >> 8)
+
+// balance between two QSCALE8 values, equivalent to BALANCE(l, x1, x2) but returning an integer
+#define QMIX(l, x1, x2)  ((uint32_t)((int32_t)(x1) * 32768 + ((int32_t)(x2) - (int32_t)(x1)) * (int32_t)((l) >> 1)) >> 23)
+
+// reciprocal used by qramp, computed once per frame rather than dividing per pixel
+static inline uint32_t qreciprocal(uint32_t span) {
+  return span ? (0x80000000UL + span - 1) / span : 0;
+}
+
+// linear ramp from 1 at x = 0 down to 0 at x = span, for 0 <= x <= span <= 2 * ANGLE_360
+static inline q16_t qramp(uint32_t x, uint32_t span, uint32_t reciprocal) {
+  q16_t l = (span - x) * reciprocal >> 15;
+  return l < Q16_ONE ? l : Q16_ONE;
+}
+
+// phase of a temporal cycle at the given time, the rate is rate/divider cycles per second
+static inline uint32_t qphase(uint8_t rate, int divider, uint32_t ms) {
+  if (divider <= 0)
+    return 0;
+  return (uint16_t)(((uint64_t)rate * ms << 16) / (1000ULL * divider));
+}
+
+// per-pixel angle increment in 16.16, for the given number of turns along n pixels
+static inline uint32_t qstep(int turns, int n, bool reverse) {
+  uint32_t step = (n > 0 ? (uint32_t)(((uint64_t)(uint32_t)turns << 32) / n) : 0);
+  return reverse ? -step : step;
+}
+
+#endif
@@ -18,9 +18,6 @@ String esp_ip_str = "noipyet";
 
 boolean 	SoftAPup 		= false;	// Enable Admin Mode for a given Time
 
-/* Debugging */
-#define DEBUGGING(...) Serial.println( __VA_ARGS__ )
-#define DEBUGGING_L(...) Serial.print( __VA_ARGS__ )
-
+/* Debugging goes through the log, see log.h */
 
 #endif
@@ -0,0 +1,432 @@
+/*
+   Per-mode render benchmark.
+
+   mode     every entry of the mode registry rendered on strips of 144, 600
+            and 2000 pixels, RGB and RGBW, with the virtual clock at 10 ms
+            per frame, the cost of handing a frame to the output driver, and
+            the share of frames that were transmitted.
+
+   fill     one color written pixel by pixel against fillPixels().
+
+   mode7    mode 7 checking the pixel format for every pixel against the
+            kernels specialized for RGB and RGBW.
+
+   lut      the LED frames through the identity, gamma and dithered output
+            tables, and mode 1 with the dithered output, as a share of the
+            10 ms frame.
+
+   output   the time a frame is on the wire, on the SPI output alone and
+            split over the SPI and the two bit-banged outputs.
+
+   web      the responses a monitor polls: the time per request, the
+            allocations and the most heap on top of the captured response.
+
+   usage: bench [--csv] [--time=ms] [--mode=n]
+ */
+
+#include <Arduino.h>
+#include <SPI.h>
+#include <chrono>
+
+#include "setup_ota.h"
+#include "dotstar_strip.h"
+#include "neopixel_mode.h"
+#include "pixel_ops.h"
+#include "mode_registry.h"
+#include "fixed_math.h"
+#include "output_lut.h"
+#include "output_driver.h"
+#include "pixel_arena.h"
+
+extern Config config;
+extern DotStarStrip strip;
+extern ESP8266WebServer server;
+
+#define DATA_LENGTH  (8 * MAX_PIXELS + 16)
+
+static const uint16_t pixelCounts[] = { 144, 600, 2000 };
+
+static uint8_t data[DATA_LENGTH];
+
+static uint64_t nowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// the previous frame leaves the wire and the clock moves on by one 100 Hz tick, outside the
+// timed region, so that a render does not wait for the emulated SPI transfer of the one before
+static void nextFrame(void) {
+  outputFlush();
+  hostAdvanceMicros(10000);
+}
+
+// encoding a frame and handing it to the output driver, without the time on the wire
+static double timeShow(uint64_t budget) {
+  uint64_t elapsed = 0;
+  uint32_t frames = 0;
+  while (elapsed < budget || frames < 5) {
+    outputFlush();
+    uint64_t start = nowNs();
+    lutEncode(strip.getPixels(), outputFrames(strip.numPixels()), strip.numPixels());
+    outputSend();
+    frames++;
+    elapsed += nowNs() - start;
+  }
+  outputFlush();
+  return (double)elapsed / frames;
+}
+
+// one color on all pixels through setPixelColor, with a yield per pixel
+static void fillLoop(uint8_t r, uint8_t g, uint8_t b) {
+  for (int pixel = 0; pixel < strip.numPixels(); pixel++) {
+    strip.setPixelColor(pixel, r, g, b);
+    yield();
+  }
+}
+
+static void fillSpan(uint8_t r, uint8_t g, uint8_t b) {
+  fillPixels(0, strip.numPixels(), r, g, b);
+}
+
+static void benchFill(bool csv, int timeMs) {
+  static void (*const fills[])(uint8_t, uint8_t, uint8_t) = { fillLoop, fillSpan };
+  static const char *names[] = { "loop", "span" };
+
+  printf("\n");
+  if (csv)
+    printf("fill,pixels,frames,ns_per_frame,ns_per_pixel\n");
+  else
+    printf("%-6s %7s %8s %14s %12s\n", "fill", "pixels", "frames", "ns/frame", "ns/pixel");
+
+  for (unsigned p = 0; p < sizeof(pixelCounts) / sizeof(pixelCounts[0]); p++) {
+    uint16_t pixels = pixelCounts[p];
+    strip.updateLength(pixels);
+    for (int f = 0; f < 2; f++) {
+      uint64_t budget = (uint64_t)timeMs * 1000000, start = nowNs(), elapsed = 0;
+      uint32_t frames = 0;
+      while (elapsed < budget || frames < 5) {
+        (*fills[f])(frames, 128, 255 - frames);
+        frames++;
+        elapsed = nowNs() - start;
+      }
+      double perFrame = (double)elapsed / frames;
+      if (csv)
+        printf("%s,%u,%u,%.0f,%.2f\n", names[f], pixels, frames, perFrame, perFrame / pixels);
+      else
+        printf("%-6s %7u %8u %14.0f %12.2f\n", names[f], pixels, frames, perFrame, perFrame / pixels);
+    }
+  }
+}
+
+static void setFormat(bool rgbw) {
+  config.leds  = rgbw ? 4 : 3;
+  config.white = rgbw ? 1 : 0;
+  modeSelect();
+}
+
+#define RGB  (config.leds==3 || (config.leds==4 && !config.white))
+#define RGBW (                  (config.leds==4 &&  config.white))
+
+// mode 7 as it was before the kernels were specialized, checking the format for every pixel
+static void branchMode7(uint16_t universe, uint16_t length, uint8_t sequence, const uint8_t * data) {
+  int i = 0, r, g, b, w = 0;
+  uint32_t position, width, ramp, step, angle, reciprocal;
+  q16_t intensity;
+  r         = data[config.offset + i++];
+  g         = data[config.offset + i++];
+  b         = data[config.offset + i++];
+  if (RGBW)
+    w       = data[config.offset + i++];
+  intensity = DMX_TO_Q16(data[config.offset + i++]);
+  position  = DMX_TO_ANGLE(data[config.offset + i++]);
+  width     = DMX_TO_ANGLE(data[config.offset + i++]);
+  ramp      = DMX_TO_ANGLE(data[config.offset + i++]);
+
+  if (config.hsv)
+    map_hsv_to_rgb(&r, &g, &b);
+
+  if (width < ANGLE_180)
+    ramp = MIN(ramp, width);
+  else
+    ramp = MIN(ramp, ANGLE_360 - width);
+  reciprocal = qreciprocal(2 * ramp);
+
+  r = QSCALE(r, intensity);
+  g = QSCALE(g, intensity);
+  b = QSCALE(b, intensity);
+  w = QSCALE(w, intensity);
+
+  step  = qstep(config.position, strip.numPixels() - 1, config.reverse);
+  angle = 0;
+  for (int pixel = 0; pixel < strip.numPixels(); pixel++, angle += step) {
+    uint32_t phase = 2 * AABS((angle >> 16) - position);
+    q16_t balance;
+
+    if (width == 0)
+      balance = 0;
+    else if (phase + ramp < width)
+      balance = Q16_ONE;
+    else if (phase > width + ramp)
+      balance = 0;
+    else
+      balance = qramp(phase + ramp - width, 2 * ramp, reciprocal);
+
+    if (RGB)
+      strip.setPixelColor(pixel, QSCALE(r, balance), QSCALE(g, balance), QSCALE(b, balance));
+    else if (RGBW) {
+      int wb = QSCALE(w, balance);
+      strip.setPixelColor(pixel, MIN(QSCALE(r, balance) + wb, 255), MIN(QSCALE(g, balance) + wb, 255), MIN(QSCALE(b, balance) + wb, 255));
+    }
+  }
+  showPixels();
+}
+
+// the same with a branch per pixel and the specialized kernels
+static void benchKernels(bool csv, int timeMs) {
+  static const ModeFunction kernels[] = { branchMode7, branchMode7, mode7<FormatRGB>, mode7<FormatRGBW> };
+  static const char *names[] = { "branch", "branch", "kernel", "kernel" };
+
+  printf("\n");
+  if (csv)
+    printf("mode7,pixels,format,frames,ns_per_frame,ns_per_pixel\n");
+  else
+    printf("%-6s %7s %-6s %8s %14s %12s\n", "mode7", "pixels", "format", "frames", "ns/frame", "ns/pixel");
+
+  for (unsigned p = 0; p < sizeof(pixelCounts) / sizeof(pixelCounts[0]); p++) {
+    uint16_t pixels = pixelCounts[p];
+    strip.updateLength(pixels);
+    for (int k = 0; k < 4; k++) {
+      bool rgbw = k & 1;
+      setFormat(rgbw);
+      uint64_t budget = (uint64_t)timeMs * 1000000, elapsed = 0;
+      uint32_t frames = 0;
+      while (elapsed < budget || frames < 5) {
+        // a different position every frame, so that all pixels are written and transmitted
+        data[4 + rgbw] = frames;
+        nextFrame();
+        uint64_t start = nowNs();
+        (*kernels[k])(config.universe, DATA_LENGTH, 0, data);
+        frames++;
+        elapsed += nowNs() - start;
+      }
+      double perFrame = (double)elapsed / frames;
+      const char *format = rgbw ? "RGBW" : "RGB";
+      if (csv)
+        printf("%s,%u,%s,%u,%.0f,%.2f\n", names[k], pixels, format, frames, perFrame, perFrame / pixels);
+      else
+        printf("%-6s %7u %-6s %8u %14.0f %12.2f\n", names[k], pixels, format, frames, perFrame, perFrame / pixels);
+    }
+  }
+  setFormat(false);
+}
+
+// the output tables on their own, then dithered, and mode 1 with the dithered output as on every tick
+static void benchLut(bool csv, int timeMs) {
+  static const char *names[] = { "copy", "gamma", "dither", "mode1" };
+  static uint8_t out[PIXEL_BYTES * MAX_PIXELS];
+  uint8_t slots[] = { 10, 20, 30, 40 };
+
+  printf("\n");
+  if (csv)
+    printf("lut,pixels,frames,ns_per_frame,ns_per_subpixel,budget\n");
+  else
+    printf("%-6s %7s %8s %14s %12s %7s\n", "lut", "pixels", "frames", "ns/frame", "ns/subpixel", "budget");
+
+  for (unsigned p = 0; p < sizeof(pixelCounts) / sizeof(pixelCounts[0]); p++) {
+    uint16_t pixels = pixelCounts[p];
+    strip.updateLength(pixels);
+    for (int k = 0; k < 4; k++) {
+      // linear output at full brightness leaves the identity tables, the LED frames are copied as they are
+      config.gamma = (k > 0);
+      config.dither = (k > 1);
+      lutBuild();
+      copyPixels(0, data, pixels);
+      uint64_t budget = (uint64_t)timeMs * 1000000, elapsed = 0;
+      uint32_t frames = 0;
+      while (elapsed < budget || frames < 5) {
+        nextFrame();
+        uint64_t start = nowNs();
+        if (k < 3)
+          lutEncode(strip.getPixels(), out, pixels);
+        else
+          mode1<FormatRGB>(config.universe, sizeof(slots), 0, slots);
+        frames++;
+        elapsed += nowNs() - start;
+      }
+      // share of the 10 ms frame at 100 Hz
+      double perFrame = (double)elapsed / frames;
+      double share = perFrame / 100000;
+      if (csv)
+        printf("%s,%u,%u,%.0f,%.2f,%.2f\n", names[k], pixels, frames, perFrame, perFrame / pixels / 3, share);
+      else
+        printf("%-6s %7u %8u %14.0f %12.2f %6.2f%%\n", names[k], pixels, frames, perFrame, perFrame / pixels / 3, share);
+    }
+  }
+  config.dither = 0;
+  lutBuild();
+}
+
+static void benchOutput(bool csv) {
+  static const char *names[] = { "spi", "split" };
+
+  printf("\n");
+  if (csv)
+    printf("output,pixels,bytes,us_per_frame,budget\n");
+  else
+    printf("%-6s %7s %8s %14s %7s\n", "output", "pixels", "bytes", "us/frame", "budget");
+
+  for (unsigned p = 0; p < sizeof(pixelCounts) / sizeof(pixelCounts[0]); p++) {
+    uint16_t pixels = pixelCounts[p];
+    strip.updateLength(pixels);
+    copyPixels(0, data, pixels);
+    // all pixels on the SPI output, then a third on each of the three outputs
+    for (int k = 0; k < 2; k++) {
+      config.slice1 = config.slice2 = (k ? pixels / 3 : 0);
+      outputFlush();
+      // on the virtual clock, with the loop polling the driver every 10 us
+      lutEncode(strip.getPixels(), outputFrames(pixels), pixels);
+      outputSend();
+      while (outputBusy()) {
+        hostAdvanceMicros(10);
+        outputPoll();
+      }
+      outputPoll();
+      uint32_t bytes = 0;
+      for (int i = 0; i < OUTPUT_COUNT; i++)
+        if (outputSlice(i))
+          bytes += 4 + PIXEL_BYTES * outputSlice(i) + 4 + outputSlice(i) / 16;
+      double share = outputTime / 100.;
+      if (csv)
+        printf("%s,%u,%u,%u,%.2f\n", names[k], pixels, (unsigned)bytes, outputTime, share);
+      else
+        printf("%-6s %7u %8u %14u %6.2f%%\n", names[k], pixels, (unsigned)bytes, outputTime, share);
+    }
+  }
+  config.slice1 = config.slice2 = 0;
+}
+
+static void benchWeb(bool csv, int timeMs) {
+  static const struct { const char *name; void (*handler)(void); } endpoints[] = {
+    { "/json", handleStatusJSON },
+    { "/status.bin", handleStatusBin },
+    { "/stats", handleStats },
+    { "/modes", handleModes },
+  };
+
+  printf("\n");
+  if (csv)
+    printf("endpoint,bytes,ns_per_request,allocations,heap\n");
+  else
+    printf("%-12s %6s %14s %11s %6s\n", "endpoint", "bytes", "ns/request", "allocations", "heap");
+
+  for (unsigned e = 0; e < sizeof(endpoints) / sizeof(endpoints[0]); e++) {
+    // the first response sizes the capture
+    server.hostReset();
+    endpoints[e].handler();
+    server.hostReset();
+    size_t inUse = hostHeapInUse;
+    hostHeapPeak = inUse;
+    uint32_t allocs = hostAllocCount;
+    endpoints[e].handler();
+    allocs = hostAllocCount - allocs;
+    size_t heap = hostHeapPeak - inUse;
+    size_t bytes = server.hostResponse.body.size();
+
+    uint64_t budget = (uint64_t)timeMs * 1000000, start = nowNs(), elapsed = 0;
+    uint32_t requests = 0;
+    while (elapsed < budget || requests < 5) {
+      server.hostReset();
+      endpoints[e].handler();
+      requests++;
+      elapsed = nowNs() - start;
+    }
+    double perRequest = (double)elapsed / requests;
+    if (csv)
+      printf("%s,%u,%.0f,%u,%u\n", endpoints[e].name, (unsigned)bytes, perRequest, allocs, (unsigned)heap);
+    else
+      printf("%-12s %6u %14.0f %11u %6u\n", endpoints[e].name, (unsigned)bytes, perRequest, allocs, (unsigned)heap);
+  }
+}
+
+int main(int argc, char **argv) {
+  bool csv = false;
+  int timeMs = 20, only = -1;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--csv"))
+      csv = true;
+    else if (!strncmp(argv[i], "--time=", 7))
+      timeMs = atoi(argv[i] + 7);
+    else if (!strncmp(argv[i], "--mode=", 7))
+      only = atoi(argv[i] + 7);
+    else {
+      fprintf(stderr, "usage: %s [--csv] [--time=ms] [--mode=n]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  hostSerialQuiet = true;
+  initialConfig();
+  config.universe = 1;
+  config.offset   = 0;
+  lutBuild();
+
+  // a deterministic, non-trivial DMX pattern
+  uint32_t seed = 12345;
+  for (int i = 0; i < DATA_LENGTH; i++) {
+    seed = seed * 1103515245 + 12345;
+    data[i] = seed >> 16;
+  }
+
+  if (csv)
+    printf("mode,pixels,format,frames,ns_per_frame,ns_per_pixel,ns_show,sent\n");
+  else
+    printf("%-6s %7s %-6s %8s %14s %12s %12s %6s\n", "mode", "pixels", "format", "frames", "ns/frame", "ns/pixel", "ns/show", "sent");
+
+  for (int m = 0; m < (int)MODE_COUNT; m++) {
+    if (only >= 0 && m != only)
+      continue;
+    for (unsigned p = 0; p < sizeof(pixelCounts) / sizeof(pixelCounts[0]); p++) {
+      for (int rgbw = 0; rgbw < 2; rgbw++) {
+        uint16_t pixels = pixelCounts[p];
+        setFormat(rgbw);
+        config.mode   = m;
+        config.pixels = pixels;
+        strip.updateLength(pixels);
+
+        // warm up, then render until the time budget is used
+        for (int i = 0; i < 3; i++) {
+          nextFrame();
+          modeTable[m].render[modeFormat](config.universe, DATA_LENGTH, 0, data);
+        }
+        uint64_t budget = (uint64_t)timeMs * 1000000, elapsed = 0;
+        uint32_t frames = 0, shown = showTransfers;
+        while (elapsed < budget || frames < 5) {
+          nextFrame();
+          uint64_t start = nowNs();
+          modeTable[m].render[modeFormat](config.universe, DATA_LENGTH, 0, data);
+          frames++;
+          elapsed += nowNs() - start;
+        }
+        outputFlush();
+
+        double perFrame = (double)elapsed / frames;
+        double sent = 100. * (showTransfers - shown) / frames;
+        double perShow = timeShow(budget);
+        const char *format = rgbw ? "RGBW" : "RGB";
+        if (csv)
+          printf("%d,%u,%s,%u,%.0f,%.2f,%.0f,%.0f\n", m, pixels, format, frames, perFrame, perFrame / pixels, perShow, sent);
+        else
+          printf("mode%-2d %7u %-6s %8u %14.0f %12.2f %12.0f %5.0f%%\n", m, pixels, format, frames, perFrame, perFrame / pixels, perShow, sent);
+      }
+    }
+  }
+  if (only < 0) {
+    benchFill(csv, timeMs);
+    benchKernels(csv, timeMs);
+    benchLut(csv, timeMs);
+    benchOutput(csv);
+    benchWeb(csv, timeMs);
+  }
+  return 0;
+}
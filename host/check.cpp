@@ -0,0 +1,2177 @@
+/*
+   Host checks for the sketch.
+
+   fixed point   modes 3-12 are rendered with the integer math of the sketch
+                 and with the original float code kept below as reference.
+                 Every subpixel has to match within +/-1 LSB. Pixels that sit
+                 exactly on a hard edge are judged against the reference
+                 evaluated with the phase nudged by a tiny amount both ways.
+
+   HSV           the integer conversions are compared against the original
+                 double precision code over all 2^24 inputs, within +/-1.
+
+   input         E1.31 packets are injected into the UDP stub, checking the
+                 frame swap, length, sequence handling and packet filtering,
+                 and frames that span several universes.
+
+   sync          the loop of the sketch is run while universes arrive in
+                 varying order, the strip has to be shown exactly once per
+                 sync packet and free-run again after the sync timeout.
+
+   scheduler     pass-through modes have to be shown in the same loop as the
+                 frame completes, animated modes on a steady 10 ms tick.
+
+   web           requests to the web server while an animated mode runs,
+                 the render keeps its rate and the worst delay of a frame
+                 is measured.
+
+   dirty         unchanged frames must not be transmitted again.
+
+   lut           gamma, brightness and white balance tables, applied only
+                 to the transmitted bytes, and the temporal dither.
+
+   output        the wire format of the strip buffer, and the
+                 double-buffered output driver, a frame goes out in
+                 chunks while the loop polls, the time on the wire, frames
+                 that have to wait for the previous one, and the slices on
+                 the hardware SPI and bit-banged outputs at the same time,
+                 whose pins are only driven while they have a slice.
+
+   hdr           the APA102 brightness and PWM split of all 16-bit values,
+                 and the 16-bit pixels of mode 13.
+
+   arena         the strip and the buffers that grow with it stay in the
+                 pixel arena, a new length does not touch the heap
+                 and a length beyond MAX_PIXELS is cut
+                 off, the strip is only resized when the length changes,
+                 the buffers that share their memory take it back.
+
+   interpolate   linear and smoothstep blends between two frames, spans that
+                 do not fit the blend buffer, and the extra renders of
+                 mode 0 while fading.
+
+   modes         footprints, validation in the dispatcher, the white channel
+                 of the RGBW kernels and /modes.
+
+   status        the JSON writer with escapes and a buffer that is too
+                 small, /json without any allocation and /status.bin.
+
+   log           messages go into the ring and reach the serial port only
+                 as far as it has room, the oldest lines are overwritten
+                 and disabled messages are not evaluated at all, /log.
+
+   config        the A/B records: a write only when something changed,
+                 the newer record wins, a damaged or half written one
+                 falls back to the other, shorter records of an older
+                 firmware, the import of config.json and the export.
+
+   assets        static files with and without a gzip copy, the ETag and
+                 the 304 answer for a file the browser already has.
+
+   stats         loss, duplicates, reordering, rates and the jitter histogram
+                 for a stream with known defects, and the /stats response.
+
+   usage: check
+ */
+
+#include <Arduino.h>
+#include <SPI.h>
+#include <ESP8266WebServer.h>
+
+#include "setup_ota.h"
+#include "dotstar_strip.h"
+#include "neopixel_mode.h"
+#include "colorspace.h"
+#include "e131_input.h"
+#include "pixel_ops.h"
+#include "e131_stats.h"
+#include "interpolate.h"
+#include "mode_registry.h"
+#include "output_lut.h"
+#include "apa102.h"
+#include "output_driver.h"
+#include "pixel_arena.h"
+#include "json_writer.h"
+#include "status_record.h"
+#include "log.h"
+#include "config_store.h"
+#include <esp8266_peri.h>
+#include "e131_packet.h"
+
+extern Config config;
+extern DotStarStrip strip;
+extern ESP8266WebServer server;
+extern uint32_t prev;
+
+void loop();
+void updateNeopixelStrip(void);
+extern uint32_t tickOverruns;
+extern long frameCounter;
+extern uint32_t webDelay;
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { if (!(cond)) { failures++; printf("FAIL: " __VA_ARGS__); printf("\n"); } } while (0)
+
+/************************************************************************************/
+
+// the double precision HSV conversion that the integer one replaced
+
+typedef struct {
+    double r;       // percent
+    double g;       // percent
+    double b;       // percent
+} rgb;
+
+typedef struct {
+    double h;       // angle in degrees
+    double s;       // percent
+    double v;       // percent
+} hsv;
+
+static hsv rgb2hsv(rgb in)
+{
+  hsv         out;
+  double      min, max, delta;
+
+  min = in.r < in.g ? in.r : in.g;
+  min = min  < in.b ? min  : in.b;
+
+  max = in.r > in.g ? in.r : in.g;
+  max = max  > in.b ? max  : in.b;
+
+  out.v = max;                              // v
+  delta = max - min;
+  if (delta < 0.00001)
+  {
+    out.s = 0;
+    out.h = 0; // undefined, maybe nan?
+    return out;
+  }
+  if ( max > 0.0 ) { // NOTE: if Max is == 0, this divide would cause a crash
+    out.s = (delta / max);                  // s
+  } else {
+    // if max is 0, then r = g = b = 0
+    // s = 0, v is undefined
+    out.s = 0.0;
+    out.h = 0. / 0.;                        // its now undefined
+    return out;
+  }
+  if ( in.r >= max )                        // > is bogus, just keeps compilor happy
+    out.h = ( in.g - in.b ) / delta;        // between yellow & magenta
+  else if ( in.g >= max )
+    out.h = 2.0 + ( in.b - in.r ) / delta;  // between cyan & yellow
+  else
+    out.h = 4.0 + ( in.r - in.g ) / delta;  // between magenta & cyan
+
+  out.h *= 60.0;                            // degrees
+
+  if ( out.h < 0.0 )
+    out.h += 360.0;
+
+  return out;
+}
+
+
+static rgb hsv2rgb(hsv in)
+{
+  double      hh, p, q, t, ff;
+  long        i;
+  rgb         out;
+
+  if (in.s <= 0.0) {      // < is bogus, just shuts up warnings
+    out.r = in.v;
+    out.g = in.v;
+    out.b = in.v;
+    return out;
+  }
+  hh = in.h;
+  if (hh >= 360.0) hh = 0.0;
+  hh /= 60.0;
+  i = (long)hh;
+  ff = hh - i;
+  p = in.v * (1.0 - in.s);
+  q = in.v * (1.0 - (in.s * ff));
+  t = in.v * (1.0 - (in.s * (1.0 - ff)));
+
+  switch (i) {
+    case 0:
+      out.r = in.v;
+      out.g = t;
+      out.b = p;
+      break;
+    case 1:
+      out.r = q;
+      out.g = in.v;
+      out.b = p;
+      break;
+    case 2:
+      out.r = p;
+      out.g = in.v;
+      out.b = t;
+      break;
+
+    case 3:
+      out.r = p;
+      out.g = q;
+      out.b = in.v;
+      break;
+    case 4:
+      out.r = t;
+      out.g = p;
+      out.b = in.v;
+      break;
+    case 5:
+    default:
+      out.r = in.v;
+      out.g = p;
+      out.b = q;
+      break;
+  }
+  return out;
+}
+
+// the reference rainbow modes use the unquantized hue in degrees
+static void ref_hsv_to_rgb(float h, int s, int v, int *r, int *g, int *b) {
+  hsv in;
+  rgb out;
+  in.h = h - 360. * floor(h / 360.);
+  in.s = s / 255.;
+  in.v = v / 255.;
+  out = hsv2rgb(in);
+  (*r) = out.r * 255;
+  (*g) = out.g * 255;
+  (*b) = out.b * 255;
+}
+
+/************************************************************************************/
+
+#define RGB  (config.leds==3 || (config.leds==4 && !config.white))
+#define RGBW (                  (config.leds==4 &&  config.white))
+
+#define REF_MAX_PIXELS 600
+
+// the reference renders into this instead of the strip
+static struct {
+  int n;
+  uint8_t px[REF_MAX_PIXELS][3];
+  int numPixels() { return n; }
+  void setPixelColor(int pixel, uint8_t r, uint8_t g, uint8_t b) {
+    px[pixel][0] = r;
+    px[pixel][1] = g;
+    px[pixel][2] = b;
+  }
+} ref;
+
+static float ref_prev;
+
+// the float implementation of modes 3-12 as it was before the fixed point port
+static void ref_mode3(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data, float eps) {
+  int i = 0, r, g, b, w;
+  float intensity, speed, ramp, duty, phase, balance = 0;
+  if (universe != config.universe)
+    return;
+  if (RGB && (length - config.offset) < (3 + 4) * config.position)
+    return;
+  if (RGBW && (length - config.offset) < (4 + 4) * config.position)
+    return;
+
+  // the code that takes care of the blinking repeats for each of the segments
+  for (int segment = 0; segment < config.position; segment++) {
+    r         = data[config.offset + i++];
+    g         = data[config.offset + i++];
+    b         = data[config.offset + i++];
+    if (RGBW)
+      w       = data[config.offset + i++];
+    intensity = data[config.offset + i++] / 255.;
+    speed     = 1. * data[config.offset + i++] / config.speed;
+    ramp      = 1. * data[config.offset + i++] * 360. / 255.;
+    duty      = 1. * data[config.offset + i++] * 360. / 255.;
+
+    if (config.hsv)
+      map_hsv_to_rgb(&r, &g, &b);
+
+    // the ramp cannot be too wide
+    if (duty < 180)
+      ramp = (ramp < duty ? ramp : duty);
+    else
+      ramp = (ramp < (360 - duty) ? ramp : (360 - duty));
+
+    // determine the current phase in the temporal cycle
+    phase = (speed * millis()) * 360. / 1000.;
+
+    // prevent rolling back
+    // only feasible with a single segment
+    if (config.position == 1 && WRAP180(phase - ref_prev) < 0)
+      phase = ref_prev;
+    else
+      ref_prev = phase;
+
+    phase = WRAP180(phase);
+    phase = ABS(phase);
+    phase += eps;
+
+    if (phase <= (duty / 2 - ramp / 4))
+      balance = 1;
+    else if (phase >= (duty / 2 + ramp / 4))
+      balance = 0;
+    else if (ramp > 0)
+      balance = ((duty / 2 + ramp / 4) - phase) / ( ramp / 2 );
+
+    // scale with the intensity
+    r *= intensity;
+    g *= intensity;
+    b *= intensity;
+    w *= intensity;
+
+    // scale with the balance
+    r *= balance;
+    g *= balance;
+    b *= balance;
+    w *= balance;
+
+    int begpixel = MAX((segment + 0) * ref.numPixels() / config.position, 0);
+    int endpixel = MIN((segment + 1) * ref.numPixels() / config.position, ref.numPixels());
+    for (int pixel = begpixel; pixel < endpixel; pixel++) {
+      if (RGB)
+        ref.setPixelColor(pixel, r, g, b);
+      //else if (RGBW)
+      //  ref.setPixelColor(pixel, r, g, b, w);
+      yield();
+    }
+  }
+}
+
+/*
+  mode 4: uniform color, blinking between color 1 and color 2
+  channel 1  = color 1 red
+  channel 2  = color 1 green
+  channel 3  = color 1 blue
+  channel 4  = color 1 white
+  channel 5  = color 2 red
+  channel 6  = color 2 green
+  channel 7  = color 2 blue
+  channel 8  = color 2 white
+  channel 9  = intensity
+  channel 10 = speed
+  channel 11 = ramp
+  channel 12 = duty cycle
+*/
+
+static void ref_mode4(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data, float eps) {
+  int i = 0, r, g, b, w, r2, g2, b2, w2;
+  float intensity, speed, ramp, duty, phase, balance = 0;
+  if (universe != config.universe)
+    return;
+  if (RGB && (length - config.offset) < 2 * 3 + 4)
+    return;
+  if (RGBW && (length - config.offset) < 2 * 4 + 4)
+    return;
+  r         = data[config.offset + i++];
+  g         = data[config.offset + i++];
+  b         = data[config.offset + i++];
+  if (RGBW)
+    w       = data[config.offset + i++];
+  r2        = data[config.offset + i++];
+  g2        = data[config.offset + i++];
+  b2        = data[config.offset + i++];
+  if (RGBW)
+    w2      = data[config.offset + i++];
+  intensity = 1. * data[config.offset + i++] / 255.;
+  speed     = 1. * data[config.offset + i++] / config.speed;
+  ramp      = 1. * data[config.offset + i++] * 360. / 255.;
+  duty      = 1. * data[config.offset + i++] * 360. / 255.;
+
+  if (config.hsv) {
+    map_hsv_to_rgb(&r, &g, &b);
+    map_hsv_to_rgb(&r2, &g2, &b2);
+  }
+
+  // the ramp cannot be too wide
+  if (duty < 180)
+    ramp = (ramp < duty ? ramp : duty);
+  else
+    ramp = (ramp < (360 - duty) ? ramp : (360 - duty));
+
+  // determine the current phase in the temporal cycle
+  phase = (speed * millis()) * 360. / 1000.;
+
+  // prevent rolling back
+  if (WRAP180(phase - ref_prev) < 0)
+    phase = ref_prev;
+  else
+    ref_prev = phase;
+
+  phase = WRAP180(phase);
+  phase = ABS(phase);
+  phase += eps;
+
+  if (phase <= (duty / 2 - ramp / 4))
+    balance = 1;
+  else if (phase >= (duty / 2 + ramp / 4))
+    balance = 0;
+  else if (ramp > 0)
+    balance = ((duty / 2 + ramp / 4) - phase) / ( ramp / 2 );
+
+  // apply the balance between the two colors
+  r = BALANCE(balance, r, r2);
+  g = BALANCE(balance, g, g2);
+  b = BALANCE(balance, b, b2);
+  w = BALANCE(balance, w, w2);
+
+  // scale with the intensity
+  r = intensity * r;
+  g = intensity * g;
+  b = intensity * b;
+  w = intensity * w;
+
+  for (int pixel = 0; pixel < ref.numPixels(); pixel++) {
+    if (RGB)
+      ref.setPixelColor(pixel, r, g, b);
+    //else if (RGBW)
+    //  ref.setPixelColor(pixel, r, g, b, w);
+    yield();
+  }
+}
+
+/*
+  mode 5: single color slider, segment that can be moved along the array (between the edges)
+  channel 1 = red
+  channel 2 = green
+  channel 3 = blue
+  channel 4 = white
+  channel 5 = intensity
+  channel 6 = position (from 0-255 or 0-360 degrees, relative to the length of the array)
+  channel 7 = width    (from 0-255 or 0-360 degrees, relative to the length of the array)
+*/
+
+static void ref_mode5(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data, float eps) {
+  int i = 0, r, g, b, w;
+  float intensity, width, position;
+  if (universe != config.universe)
+    return;
+  if (RGB && (length - config.offset) < 3 + 3)
+    return;
+  if (RGBW && (length - config.offset) < 4 + 3)
+    return;
+  r         = data[config.offset + i++];
+  g         = data[config.offset + i++];
+  b         = data[config.offset + i++];
+  if (RGBW)
+    w       = data[config.offset + i++];
+  intensity = data[config.offset + i++] / 255.;
+  position  = data[config.offset + i++] * (ref.numPixels() - 1) / 255.;
+  width     = data[config.offset + i++] * (ref.numPixels() - 0) / 255.;
+
+  if (config.hsv)
+    map_hsv_to_rgb(&r, &g, &b);
+
+  // scale with the intensity
+  r = intensity * r;
+  g = intensity * g;
+  b = intensity * b;
+  w = intensity * w;
+
+  // the position needs to be corrected for the width
+  position -= ref.numPixels() / 2;
+  position /= ref.numPixels() / 2;
+  position *= (ref.numPixels() - width) / 2;
+  position += ref.numPixels() / 2;
+
+  // express the position and with as phase along the strip
+  position *= 360. / ref.numPixels();
+  width    *= 360. / ref.numPixels();
+
+  for (int pixel = 0; pixel < ref.numPixels(); pixel++) {
+    int flip = (config.reverse ? -1 : 1);
+    float phase, balance = 0;
+
+    phase = WRAP180((360. * flip * pixel / ref.numPixels()) * config.position - position);
+    phase = ABS(phase);
+    phase += eps;
+
+    if (width == 0)
+      balance = 0;
+    else if (phase <= width / 2)
+      balance = 1;
+    else
+      balance = 0;
+
+    if (RGB)
+      ref.setPixelColor(pixel, balance * r, balance * g, balance * b);
+    //else if (RGBW)
+    //  ref.setPixelColor(pixel, balance * r, balance * g, balance * b, balance * w);
+    yield();
+  }
+}
+
+/*
+  mode 6: dual color slider, segment can be moved along the array (between the edges)
+  channel 1  = color 1 red
+  channel 2  = color 1 green
+  channel 3  = color 1 blue
+  channel 4  = color 1 white
+  channel 5  = color 2 red
+  channel 6  = color 2 green
+  channel 7  = color 2 blue
+  channel 8  = color 2 white
+  channel 9  = intensity
+  channel 10 = position (from 0-255 or 0-360 degrees, relative to the length of the array)
+  channel 11 = width    (from 0-255 or 0-360 degrees, relative to the length of the array)
+*/
+
+static void ref_mode6(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data, float eps) {
+  int i = 0, r, g, b, r2, g2, b2;
+  float intensity, width, position;
+  if (universe != config.universe)
+    return;
+  if (RGB && (length - config.offset) < 2 * 3 + 3)
+    return;
+  if (RGBW && (length - config.offset) < 2 * 4 + 3)
+    return;
+  r         = data[config.offset + i++];
+  g         = data[config.offset + i++];
+  b         = data[config.offset + i++];
+  if (RGBW)
+    i++;      // white, the reference only renders RGB
+  r2        = data[config.offset + i++];
+  g2        = data[config.offset + i++];
+  b2        = data[config.offset + i++];
+  if (RGBW)
+    i++;
+  intensity = data[config.offset + i++] / 255.;
+  position  = data[config.offset + i++] * (ref.numPixels() - 1) / 255.;
+  width     = data[config.offset + i++] * (ref.numPixels() - 0) / 255.;
+
+  if (config.hsv) {
+    map_hsv_to_rgb(&r, &g, &b);
+    map_hsv_to_rgb(&r2, &g2, &b2);
+  }
+
+  // the position needs to be corrected for the width
+  position -= ref.numPixels() / 2;
+  position /= ref.numPixels() / 2;
+  position *= (ref.numPixels() - width) / 2;
+  position += ref.numPixels() / 2;
+
+  // express the position and with as phase along the strip
+  position *= 360. / ref.numPixels();
+  width    *= 360. / ref.numPixels();
+
+  for (int pixel = 0; pixel < ref.numPixels(); pixel++) {
+    int flip = (config.reverse ? -1 : 1);
+    float phase, balance = 0;
+
+    phase = WRAP180((360. * flip * pixel / (ref.numPixels() - 1)) * config.position - position);
+    phase = ABS(phase);
+    phase += eps;
+
+    if (width == 0)
+      balance = 0;
+    else if (phase <= width / 2)
+      balance = 1;
+    else
+      balance = 0;
+
+    if (RGB)
+      ref.setPixelColor(pixel, intensity * BALANCE(balance, r, r2), intensity * BALANCE(balance, g, g2), intensity * BALANCE(balance, b, b2));
+    //else if (RGBW)
+    //  ref.setPixelColor(pixel, intensity * BALANCE(balance, r, r2), intensity * BALANCE(balance, g, g2), intensity * BALANCE(balance, b, b2), intensity * BALANCE(balance, w, w2));
+    yield();
+  }
+}
+
+/*
+  mode 7: single color smooth slider, segment can be moved along the array (continuous over the edge)
+  channel 1 = red
+  channel 2 = green
+  channel 3 = blue
+  channel 4 = white
+  channel 5 = intensity
+  channel 6 = position (from 0-255 or 0-360 degrees, relative to the length of the array)
+  channel 7 = width    (from 0-255 or 0-360 degrees, relative to the length of the array)
+  channel 8 = ramp     (from 0-255 or 0-360 degrees, relative to the length of the array)
+*/
+
+static void ref_mode7(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data, float eps) {
+  int i = 0, r, g, b, w;
+  float intensity, position, width, ramp;
+  if (universe != config.universe)
+    return;
+  if (RGB && (length - config.offset) < 3 + 4)
+    return;
+  if (RGBW && (length - config.offset) < 4 + 4)
+    return;
+  r         = data[config.offset + i++];
+  g         = data[config.offset + i++];
+  b         = data[config.offset + i++];
+  if (RGBW)
+    w       = data[config.offset + i++];
+  intensity = data[config.offset + i++] / 255.;
+  position  = data[config.offset + i++] * 360. / 255.;
+  width     = data[config.offset + i++] * 360. / 255.;
+  ramp      = data[config.offset + i++] * 360. / 255.;
+
+  if (config.hsv)
+    map_hsv_to_rgb(&r, &g, &b);
+
+  // the ramp cannot be too wide
+  if (width < 180)
+    ramp = (ramp < width ? ramp : width);
+  else
+    ramp = (ramp < (360 - width) ? ramp : (360 - width));
+
+  // scale with the intensity
+  r = intensity * r;
+  g = intensity * g;
+  b = intensity * b;
+  w = intensity * w;
+
+  for (int pixel = 0; pixel < ref.numPixels(); pixel++) {
+    int flip = (config.reverse ? -1 : 1);
+    float phase, balance = 0;
+
+    phase = WRAP180(360. * flip * pixel / (ref.numPixels() - 1) * config.position - position);
+    phase = ABS(phase);
+    phase += eps;
+
+    if (width == 0)
+      balance = 0;
+    else if (phase < (width / 2. - ramp / 2.))
+      balance = 1;
+    else if (phase > (width / 2. + ramp / 2.))
+      balance = 0;
+    else if (ramp > 0)
+      balance = ((width / 2. + ramp / 2.) - phase) / ramp;
+
+    if (RGB)
+      ref.setPixelColor(pixel, balance * r, balance * g, balance * b);
+    //else if (RGBW)
+    //  ref.setPixelColor(pixel, balance * r, balance * g, balance * b, balance * w);
+    yield();
+  }
+}
+
+/*
+  mode 8: dual color smooth slider, segment can be moved along the array (continuous over the edge)
+  channel 1  = color 1 red
+  channel 2  = color 1 green
+  channel 3  = color 1 blue
+  channel 4  = color 1 white
+  channel 5  = color 2 red
+  channel 6  = color 2 green
+  channel 7  = color 2 blue
+  channel 8  = color 2 white
+  channel 9  = intensity
+  channel 10 = position (from 0-255 or 0-360 degrees, relative to the length of the array)
+  channel 11 = width    (from 0-255 or 0-360 degrees, relative to the length of the array)
+  channel 12 = ramp     (from 0-255 or 0-360 degrees, relative to the length of the array)
+*/
+
+static void ref_mode8(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data, float eps) {
+  int i = 0, r, g, b, r2, g2, b2;
+  float intensity, position, width, ramp;
+  if (universe != config.universe)
+    return;
+  if (RGB && (length - config.offset) < 2 * 3 + 4)
+    return;
+  if (RGBW && (length - config.offset) < 2 * 4 + 4)
+    return;
+  r         = data[config.offset + i++];
+  g         = data[config.offset + i++];
+  b         = data[config.offset + i++];
+  if (RGBW)
+    i++;      // white, the reference only renders RGB
+  r2        = data[config.offset + i++];
+  g2        = data[config.offset + i++];
+  b2        = data[config.offset + i++];
+  if (RGBW)
+    i++;
+  intensity = data[config.offset + i++] / 255.;
+  position  = data[config.offset + i++] * 360. / 255.;
+  width     = data[config.offset + i++] * 360. / 255.;
+  ramp      = data[config.offset + i++] * 360. / 255.;
+
+  if (config.hsv) {
+    map_hsv_to_rgb(&r, &g, &b);
+    map_hsv_to_rgb(&r2, &g2, &b2);
+  }
+
+  // the ramp cannot be too wide
+  if (width < 180)
+    ramp = (ramp < width ? ramp : width);
+  else
+    ramp = (ramp < (360 - width) ? ramp : (360 - width));
+
+  for (int pixel = 0; pixel < ref.numPixels(); pixel++) {
+    int flip = (config.reverse ? -1 : 1);
+    float phase, balance = 0;
+
+    phase = WRAP180(360. * flip * pixel / (ref.numPixels() - 1) * config.position - position);
+    phase = ABS(phase);
+    phase += eps;
+
+    if (width == 0)
+      balance = 0;
+    else if (phase < (width / 2. - ramp / 2.))
+      balance = 1;
+    else if (phase > (width / 2. + ramp / 2.))
+      balance = 0;
+    else if (ramp > 0)
+      balance = ((width / 2. + ramp / 2.) - phase) / ramp;
+
+    if (RGB)
+      ref.setPixelColor(pixel, intensity * BALANCE(balance, r, r2), intensity * BALANCE(balance, g, g2), intensity * BALANCE(balance, b, b2));
+    //else if (RGBW)
+    //  ref.setPixelColor(pixel, intensity * BALANCE(balance, r, r2), intensity * BALANCE(balance, g, g2), intensity * BALANCE(balance, b, b2), intensity * BALANCE(balance, w, w2));
+    yield();
+  }
+}
+
+/*
+  mode 9: spinning color wheel
+  channel 1 = red
+  channel 2 = green
+  channel 3 = blue
+  channel 4 = white
+  channel 5 = intensity
+  channel 6 = speed
+  channel 7 = width
+  channel 8 = ramp
+*/
+
+static void ref_mode9(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data, float eps) {
+  int i = 0, r, g, b, w;
+  float intensity, speed, width, ramp, phase;
+  if (universe != config.universe)
+    return;
+  if (RGB && (length - config.offset) < 3 + 4)
+    return;
+  if (RGBW && (length - config.offset) < 4 + 4)
+    return;
+  r         = data[config.offset + i++];
+  g         = data[config.offset + i++];
+  b         = data[config.offset + i++];
+  if (RGBW)
+    w       = data[config.offset + i++];
+  intensity = 1. * data[config.offset + i++] / 255.;
+  speed     = 1. * data[config.offset + i++] / config.speed;
+  width     = 1. * data[config.offset + i++] * 360. / 255.;
+  ramp      = 1. * data[config.offset + i++] * 360. / 255.;
+
+  if (config.hsv)
+    map_hsv_to_rgb(&r, &g, &b);
+
+  // the ramp cannot be too wide
+  if (width < 180)
+    ramp = (ramp < width ? ramp : width);
+  else
+    ramp = (ramp < (360 - width) ? ramp : (360 - width));
+
+  // scale with the intensity
+  r = intensity * r;
+  g = intensity * g;
+  b = intensity * b;
+  w = intensity * w;
+
+  // determine the current phase in the temporal cycle
+  phase = (speed * millis()) * 360. / 1000.;
+
+  // prevent rolling back
+  if (WRAP180(phase - ref_prev) < 0)
+    phase = ref_prev;
+  else
+    ref_prev = phase;
+
+  for (int pixel = 0; pixel < ref.numPixels(); pixel++) {
+    int flip = (config.reverse ? -1 : 1);
+    float position, balance = 0;
+
+    position = WRAP180(360. * flip * pixel / (ref.numPixels() - 1) * config.position - phase);
+    position = ABS(position);
+    position += eps;
+
+    if (width == 0)
+      balance = 0;
+    else if (position < (width / 2. - ramp / 2.))
+      balance = 1;
+    else if (position > (width / 2. + ramp / 2.))
+      balance = 0;
+    else if (position > 0)
+      balance = ((width / 2. + ramp / 2.) - position) / ramp;
+
+    if (RGB)
+      ref.setPixelColor(pixel, balance * r, balance * g, balance * b);
+    //else if (RGBW)
+    //  ref.setPixelColor(pixel, balance * r, balance * g, balance * b, balance * w);
+    yield();
+  }
+}
+
+/*
+  mode 10: spinning color wheel with color background
+  channel 1  = color 1 red
+  channel 2  = color 1 green
+  channel 3  = color 1 blue
+  channel 4  = color 1 white
+  channel 5  = color 2 red
+  channel 6  = color 2 green
+  channel 7  = color 2 blue
+  channel 8  = color 2 white
+  channel 9  = intensity
+  channel 10 = speed
+  channel 11 = width
+  channel 12 = ramp
+*/
+
+static void ref_mode10(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data, float eps) {
+  int i = 0, r, g, b, r2, g2, b2;
+  float intensity, speed, width, ramp, phase;
+  if (universe != config.universe)
+    return;
+  if (RGB && (length - config.offset) < 2 * 3 + 4)
+    return;
+  if (RGBW && (length - config.offset) < 2 * 4 + 4)
+    return;
+  r         = data[config.offset + i++];
+  g         = data[config.offset + i++];
+  b         = data[config.offset + i++];
+  if (RGBW)
+    i++;      // white, the reference only renders RGB
+  r2        = data[config.offset + i++];
+  g2        = data[config.offset + i++];
+  b2        = data[config.offset + i++];
+  if (RGBW)
+    i++;
+  intensity = 1. * data[config.offset + i++] / 255.;
+  speed     = 1. * data[config.offset + i++] / config.speed;
+  width     = 1. * data[config.offset + i++] * 360. / 255.;
+  ramp      = 1. * data[config.offset + i++] * 360. / 255.;
+
+  if (config.hsv) {
+    map_hsv_to_rgb(&r, &g, &b);
+    map_hsv_to_rgb(&r2, &g2, &b2);
+  }
+
+  // the ramp cannot be too wide
+  if (width < 180)
+    ramp = (ramp < width ? ramp : width);
+  else
+    ramp = (ramp < (360 - width) ? ramp : (360 - width));
+
+  // determine the current phase in the temporal cycle
+  phase = (speed * millis()) * 360. / 1000.;
+
+  // prevent rolling back
+  if (WRAP180(phase - ref_prev) < 0)
+    phase = ref_prev;
+  else
+    ref_prev = phase;
+
+  for (int pixel = 0; pixel < ref.numPixels(); pixel++) {
+    int flip = (config.reverse ? -1 : 1);
+    float position, balance = 0;
+
+    position = WRAP180((360. * flip * pixel / (ref.numPixels() - 1)) * config.position - phase);
+    position = ABS(position);
+    position += eps;
+
+    if (width == 0)
+      balance = 0;
+    else if (position < (width / 2. - ramp / 2.))
+      balance = 1;
+    else if (position > (width / 2. + ramp / 2.))
+      balance = 0;
+    else if (position > 0)
+      balance = ((width / 2. + ramp / 2.) - position) / ramp;
+
+    if (RGB)
+      ref.setPixelColor(pixel, intensity * BALANCE(balance, r, r2), intensity * BALANCE(balance, g, g2), intensity * BALANCE(balance, b, b2));
+    //else if (RGBW)
+    //  ref.setPixelColor(pixel, intensity * BALANCE(balance, r, r2), intensity * BALANCE(balance, g, g2), intensity * BALANCE(balance, b, b2), intensity * BALANCE(balance, w, w2));
+    yield();
+  }
+}
+
+/*
+  mode 11: rainbow slider
+  channel 1 = saturation
+  channel 2 = value
+  channel 3 = position
+*/
+
+static void ref_mode11(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data, float eps) {
+  int i = 0;
+  float saturation, value, position;
+
+  if (universe != config.universe)
+    return;
+  if ((length - config.offset) < 3)
+    return;
+  saturation = 1. * data[config.offset + i++];
+  value      = 1. * data[config.offset + i++] ;
+  position   = 1. * data[config.offset + i++] * 360. / 255.;
+
+  for (int pixel = 0; pixel < ref.numPixels(); pixel++) {
+    int flip = (config.reverse ? -1 : 1);
+    float phase = WRAP360((360. * flip * pixel / ref.numPixels()) * config.position - position);
+    phase += eps;
+
+    int r, g, b;
+    ref_hsv_to_rgb(phase, saturation, value, &r, &g, &b);
+
+    ref.setPixelColor(pixel, r, g, b);
+    yield();
+  }
+}
+
+/*
+  mode 12: rainbow spinner
+  channel 1 = saturation
+  channel 2 = value
+  channel 3 = speed
+*/
+
+static void ref_mode12(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data, float eps) {
+  int i = 0;
+  float saturation, value, speed, phase;
+
+  if (universe != config.universe)
+    return;
+  if ((length - config.offset) < 3)
+    return;
+  saturation = 1. * data[config.offset + i++];
+  value      = 1. * data[config.offset + i++] ;
+  speed      = 1. * data[config.offset + i++] / config.speed;
+
+  // determine the current phase in the temporal cycle
+  phase = (speed * millis()) * 360. / 1000.;
+
+  // prevent rolling back
+  if (WRAP180(phase - ref_prev) < 0)
+    phase = ref_prev;
+  else
+    ref_prev = phase;
+
+  for (int pixel = 0; pixel < ref.numPixels(); pixel++) {
+    int flip = (config.reverse ? -1 : 1);
+    float position = WRAP360((360. * flip * pixel / ref.numPixels()) * config.position - phase);
+    position += eps;
+
+    int r, g, b;
+    ref_hsv_to_rgb(position, saturation, value, &r, &g, &b);
+
+    ref.setPixelColor(pixel, r, g, b);
+    yield();
+  }
+}
+
+
+
+typedef void (*RefMode)(uint16_t, uint16_t, uint8_t, uint8_t *, float);
+typedef void (*Mode)(uint16_t, uint16_t, uint8_t, const uint8_t *);
+
+static void checkFixedPoint() {
+  static const RefMode refs[] = { ref_mode3, ref_mode4, ref_mode5, ref_mode6, ref_mode7, ref_mode8, ref_mode9, ref_mode10, ref_mode11, ref_mode12 };
+  static const Mode modes[]   = { mode3<FormatRGB>, mode4<FormatRGB>, mode5<FormatRGB>, mode6<FormatRGB>, mode7<FormatRGB>,
+                                 mode8<FormatRGB>, mode9<FormatRGB>, mode10<FormatRGB>, mode11<FormatRGB>, mode12<FormatRGB> };
+  static const int pixelCounts[] = { 2, 12, 144, 600 };
+  static const uint32_t startTimes[] = { 0, 500, 1500 };
+  const float eps = 0.02;
+  uint8_t data[512];
+  uint8_t lo[REF_MAX_PIXELS][3], hi[REF_MAX_PIXELS][3];
+
+  config.universe = 1;
+  config.offset   = 0;
+  config.leds     = 3;
+  config.white    = 0;
+  config.hsv      = 0;
+  config.speed    = 8;
+
+  for (int m = 0; m < 10; m++) {
+    long compared = 0, edges = 0;
+    int worst = 0;
+    uint32_t seed = 1 + m;
+
+    for (unsigned p = 0; p < sizeof(pixelCounts) / sizeof(pixelCounts[0]); p++)
+      for (int reverse = 0; reverse < 2; reverse++)
+        for (int position = 1; position <= 3; position++)
+          for (unsigned t = 0; t < sizeof(startTimes) / sizeof(startTimes[0]); t++) {
+            config.pixels   = pixelCounts[p];
+            config.reverse  = reverse;
+            config.position = position;
+            strip.updateLength(config.pixels);
+            ref.n = config.pixels;
+            for (int i = 0; i < 512; i++) {
+              seed = seed * 1103515245 + 12345;
+              data[i] = seed >> 16;
+            }
+            hostSetMicros((uint64_t)startTimes[t] * 1000);
+            ref_prev = 0;
+            prev = 0;
+
+            for (int frame = 0; frame < 20; frame++) {
+              // the references first, showing the frame can wait for the previous one on the virtual clock
+              (*refs[m])(1, 512, 0, data, -eps);
+              memcpy(lo, ref.px, sizeof(lo));
+              (*refs[m])(1, 512, 0, data, +eps);
+              memcpy(hi, ref.px, sizeof(hi));
+              (*refs[m])(1, 512, 0, data, 0);
+
+              (*modes[m])(1, 512, 0, data);
+
+              for (int pixel = 0; pixel < config.pixels; pixel++) {
+                uint32_t c = strip.getPixelColor(pixel);
+                uint8_t actual[3] = { (uint8_t)(c >> 16), (uint8_t)(c >> 8), (uint8_t)c };
+                for (int k = 0; k < 3; k++) {
+                  int a = ref.px[pixel][k], b = lo[pixel][k], d = hi[pixel][k];
+                  int vmin = MIN(a, MIN(b, d)), vmax = MAX(a, MAX(b, d));
+                  int diff = abs(actual[k] - a);
+                  if (vmax - vmin > 1)
+                    edges++;
+                  else if (diff > worst)
+                    worst = diff;
+                  CHECK(actual[k] + 1 >= vmin && actual[k] <= vmax + 1,
+                        "mode%d pixels=%d reverse=%d position=%d t=%lu pixel=%d channel=%d: %d, reference %d (%d-%d)",
+                        m + 3, config.pixels, reverse, position, millis(), pixel, k, actual[k], a, vmin, vmax);
+                  compared++;
+                }
+              }
+              hostAdvanceMicros(10000);
+            }
+          }
+    printf("mode%-2d  fixed point vs float: %ld subpixels, max deviation %d LSB, %ld on an edge\n", m + 3, compared, worst, edges);
+  }
+}
+
+static void checkHsv() {
+  long mismatches = 0, exact = 0, total = 0;
+  int worst = 0;
+
+  // all 8-bit hue, saturation and value combinations
+  for (int h = 0; h < 256; h++)
+    for (int s = 0; s < 256; s++)
+      for (int v = 0; v < 256; v++) {
+        hsv in;
+        rgb out;
+        uint8_t r, g, b;
+        in.h = 360. * h / 256.;
+        in.s = s / 255.;
+        in.v = v / 255.;
+        out = hsv2rgb(in);
+        hsv2rgb8(h, s, v, &r, &g, &b);
+        int d = MAX(abs(r - (int)(out.r * 255)), MAX(abs(g - (int)(out.g * 255)), abs(b - (int)(out.b * 255))));
+        worst = MAX(worst, d);
+        exact += (d == 0);
+        mismatches += (d > 1);
+        total++;
+      }
+  CHECK(mismatches == 0, "hsv2rgb8: %ld of %ld inputs differ by more than 1", mismatches, total);
+  printf("hsv2rgb8   vs double: %ld inputs, %ld exact, max deviation %d\n", total, exact, worst);
+
+  // all 16-bit hues for a selection of saturation and value levels
+  static const uint8_t levels[] = { 0, 1, 17, 128, 200, 254, 255 };
+  mismatches = exact = total = worst = 0;
+  for (long h = 0; h < 65536; h++)
+    for (unsigned i = 0; i < sizeof(levels); i++)
+      for (unsigned j = 0; j < sizeof(levels); j++) {
+        hsv in;
+        rgb out;
+        uint8_t r, g, b;
+        in.h = 360. * h / 65536.;
+        in.s = levels[i] / 255.;
+        in.v = levels[j] / 255.;
+        out = hsv2rgb(in);
+        hsv2rgb16(h, levels[i], levels[j], &r, &g, &b);
+        int d = MAX(abs(r - (int)(out.r * 255)), MAX(abs(g - (int)(out.g * 255)), abs(b - (int)(out.b * 255))));
+        worst = MAX(worst, d);
+        exact += (d == 0);
+        mismatches += (d > 1);
+        total++;
+      }
+  CHECK(mismatches == 0, "hsv2rgb16: %ld of %ld inputs differ by more than 1", mismatches, total);
+  printf("hsv2rgb16  vs double: %ld inputs, %ld exact, max deviation %d\n", total, exact, worst);
+
+  // all RGB colors, the hue is compared in units of 1/65536 turn
+  mismatches = exact = total = worst = 0;
+  for (int r = 0; r < 256; r++)
+    for (int g = 0; g < 256; g++)
+      for (int b = 0; b < 256; b++) {
+        rgb in;
+        hsv out;
+        uint16_t h;
+        uint8_t s, v;
+        in.r = r / 255.;
+        in.g = g / 255.;
+        in.b = b / 255.;
+        out = rgb2hsv(in);
+        rgb2hsv16(r, g, b, &h, &s, &v);
+        int dh = abs((int16_t)(h - (uint16_t)(long)(out.h * 65536. / 360.)));
+        int d  = MAX(dh, MAX(abs(s - (int)(out.s * 255)), abs(v - (int)(out.v * 255))));
+        worst = MAX(worst, d);
+        exact += (d == 0);
+        mismatches += (d > 1);
+        total++;
+      }
+  CHECK(mismatches == 0, "rgb2hsv16: %ld of %ld inputs differ by more than 1", mismatches, total);
+  printf("rgb2hsv16  vs double: %ld inputs, %ld exact, max deviation %d\n", total, exact, worst);
+}
+
+/************************************************************************************/
+
+static void checkInput() {
+  uint8_t slots[DMX_SLOTS];
+  for (int i = 0; i < DMX_SLOTS; i++)
+    slots[i] = i * 7;
+
+  inputBegin();
+  const DmxFrame *initial = inputFrame();
+  CHECK(initial->length == 510 && initial->data[0] == 0, "input: initial frame not blank");
+  CHECK(!inputPoll(), "input: frame without packet");
+
+  hostSetMicros(1234000);
+  e131SendData(config.universe, 10, slots, 300);
+  CHECK(inputPoll(), "input: packet not accepted");
+  const DmxFrame *frame = inputFrame();
+  CHECK(frame != initial, "input: frames not swapped");
+  CHECK(frame->universe == config.universe && frame->length == 300 && frame->sequence == 10 && frame->timestamp == 1234,
+        "input: universe %u length %u sequence %u timestamp %u", frame->universe, frame->length, frame->sequence, frame->timestamp);
+  CHECK(!memcmp(frame->data, slots, 300), "input: slots differ");
+
+  // rejected packets leave the frame alone
+  e131SendData(config.universe + 1, 11, slots + 1, 512);
+  e131SendData(config.universe, 11, slots + 1, 512, 0, 0x80);
+  e131SendData(config.universe, 9, slots + 1, 512);
+  e131SendData(config.universe, 10, slots + 1, 512);
+  for (int i = 0; i < 4; i++)
+    CHECK(!inputPoll(), "input: packet %d not rejected", i);
+  CHECK(inputFrame() == frame && frame->length == 300 && !memcmp(frame->data, slots, 300), "input: frame changed");
+
+  // a large step back is a restarted source, the sequence wraps at 255
+  e131SendData(config.universe, 200, slots + 2, 512);
+  e131SendData(config.universe, 3, slots, 512);
+  CHECK(inputPoll() && inputFrame()->sequence == 200, "input: restarted source");
+  CHECK(inputPoll() && inputFrame()->sequence == 3, "input: sequence wrap");
+  // only whole pixels of mode 0 are kept
+  CHECK(inputPrevious()->sequence == 200 && inputFrame()->length == 510, "input: frames not rotated");
+
+  // a truncated packet only fills what was received
+  uint8_t buf[E131_PACKET_MAX];
+  size_t len = e131DataPacket(buf, config.universe, 4, slots, 512);
+  hostUdpInject(E131_PORT, buf, len - 100);
+  CHECK(inputPoll() && inputFrame()->length == 412, "input: truncated packet");
+  hostUdpInject(E131_PORT, buf, 100);
+  CHECK(!inputPoll(), "input: short packet");
+
+  printf("input: ok\n");
+}
+
+static void checkUniverses() {
+  uint8_t slots[3][DMX_SLOTS];
+  for (int u = 0; u < 3; u++)
+    for (int i = 0; i < DMX_SLOTS; i++)
+      slots[u][i] = u * 64 + i;
+
+  // 2 slots in front of the first pixel, 170 + 170 + 100 RGB pixels
+  config.universes = 3;
+  config.offset = 2;
+  config.leds = 3;
+  config.pixels = 440;
+  config.hsv = 0;
+  strip.updateLength(config.pixels);
+  inputBegin();
+
+  e131SendData(config.universe, 1, slots[0], 512);
+  e131SendData(config.universe + 1, 1, slots[1], 512);
+  e131SendData(config.universe + 3, 1, slots[0], 512);
+  e131SendData(config.universe + 2, 1, slots[2], 300);
+  CHECK(!inputPoll() && !inputPoll() && !inputPoll(), "universes: frame complete too early");
+  CHECK(inputPoll(), "universes: frame not complete");
+  const DmxFrame *frame = inputFrame();
+  CHECK(frame->length == 2 + 510 + 510 + 300, "universes: length %u", frame->length);
+
+  mode0<FormatRGB>(frame->universe, frame->length, frame->sequence, frame->data);
+  int mismatches = 0;
+  for (int pixel = 0; pixel < config.pixels; pixel++) {
+    int u = (pixel < 170 ? 0 : pixel < 340 ? 1 : 2);
+    int slot = (u == 0 ? 2 : 0) + 3 * (pixel - 170 * u);
+    uint32_t c = strip.getPixelColor(pixel);
+    mismatches += (c != ((uint32_t)slots[u][slot] << 16 | slots[u][slot + 1] << 8 | slots[u][slot + 2]));
+  }
+  CHECK(mismatches == 0, "universes: %d pixels differ", mismatches);
+
+  // a lost packet keeps the universe of the previous frame
+  slots[0][2] = slots[1][0] = 0xaa;
+  e131SendData(config.universe, 2, slots[0], 512);
+  e131SendData(config.universe + 1, 2, slots[1], 512);
+  e131SendData(config.universe, 3, slots[0], 512);
+  CHECK(!inputPoll() && !inputPoll() && inputPoll(), "universes: lost packet");
+  frame = inputFrame();
+  CHECK(frame->data[2] == 0xaa && frame->data[512] == 0xaa && frame->data[1022] == slots[2][0] && frame->length == 1322,
+        "universes: lost packet not carried over");
+
+  config.universes = 1;
+  config.offset = 0;
+  initialConfig();
+  inputBegin();
+  printf("universes: ok\n");
+}
+
+/************************************************************************************/
+
+// run the loop of the sketch for the given time in steps of about 10 ms, returns the number of frames shown
+static uint32_t runLoop(uint32_t ms) {
+  uint32_t shown = showTransfers;
+  uint32_t end = millis() + ms;
+  while (millis() < end) {
+    hostAdvanceMicros(9000);
+    loop();   // includes a delay(1)
+  }
+  return showTransfers - shown;
+}
+
+static void checkSync() {
+  const uint16_t sync = 7000;
+  static const int order[3][3] = { { 0, 1, 2 }, { 2, 0, 1 }, { 1, 2, 0 } };
+  uint8_t slots[DMX_SLOTS];
+  uint8_t seq = 0;
+
+  config.universes = 3;
+  config.leds = 3;
+  config.pixels = 440;
+  config.mode = 0;
+  strip.updateLength(config.pixels);
+  hostAdvanceMicros(10000000);
+  inputBegin();
+
+  // the source announces the sync address, until its first sync packet the frames run free
+  runLoop(100);
+  for (int u = 0; u < 3; u++)
+    e131SendData(config.universe + u, seq, slots, 512, sync);
+  e131SendSync(sync, seq++);
+  CHECK(runLoop(100) == 1, "sync: first frame");
+
+  int early = 0, missed = 0;
+  for (int frame = 0; frame < 30; frame++) {
+    memset(slots, frame, sizeof(slots));
+    for (int i = 0; i < 3; i++) {
+      e131SendData(config.universe + order[frame % 3][i], seq, slots, 512, sync);
+      e131SendData(config.universe + 5, seq, slots, 512, sync);
+      early += runLoop(20);
+    }
+    early += runLoop(50);
+    e131SendSync(sync, seq++);
+    uint32_t shown = runLoop(50);
+    missed += (shown != 1);
+    CHECK(strip.getPixelColor(439) == ((uint32_t)frame * 0x010101), "sync: frame %d not latched", frame);
+  }
+  CHECK(early == 0, "sync: %d frames shown before their sync packet", early);
+  CHECK(missed == 0, "sync: %d sync packets without exactly one show", missed);
+
+  // when the sync packets stop the frames are held for SYNC_TIMEOUT, then run free
+  memset(slots, 0x80, sizeof(slots));
+  for (int u = 0; u < 3; u++)
+    e131SendData(config.universe + u, seq, slots, 512, sync);
+  seq++;
+  CHECK(runLoop(SYNC_TIMEOUT - 200) == 0, "sync: frame not held");
+  CHECK(runLoop(400) == 1, "sync: no fallback to free-run");
+  memset(slots, 0x90, sizeof(slots));
+  for (int u = 0; u < 3; u++)
+    e131SendData(config.universe + u, seq, slots, 512, sync);
+  seq++;
+  CHECK(runLoop(50) == 1, "sync: not running free");
+
+  initialConfig();
+  inputBegin();
+  printf("sync: ok\n");
+}
+
+/************************************************************************************/
+
+static void checkScheduler() {
+  uint8_t slots[DMX_SLOTS];
+  memset(slots, 0x40, sizeof(slots));
+
+  config.mode = 0;
+  config.leds = 3;
+  config.pixels = 144;
+  strip.updateLength(config.pixels);
+  inputBegin();
+  runLoop(2000);
+
+  // a pass-through frame is shown without waiting for a tick
+  uint32_t shown = showTransfers;
+  e131SendData(config.universe, 1, slots, 512);
+  loop();
+  CHECK(showTransfers == shown + 1 && strip.getPixelColor(0) == 0x404040, "scheduler: mode 0 not shown right away");
+  CHECK(runLoop(100) == 0, "scheduler: mode 0 shown without a new frame");
+
+  // animated modes follow the tick, whatever the loop rate
+  config.mode = 3;
+  runLoop(1000);
+  int frames = 0, irregular = 0;
+  uint32_t last = 0, start = micros();
+  for (int step = 0; step < 10000; step++) {
+    hostAdvanceMicros(100 + (step * 37) % 300);
+    long rendered = frameCounter;
+    loop();
+    if (frameCounter != rendered) {
+      // the loop runs every 100 to 400 us, so a tick is seen that much later
+      if (frames++ && (micros() - last < 9600 || micros() - last > 10400))
+        irregular++;
+      last = micros();
+    }
+  }
+  int expected = (micros() - start) / 10000;
+  CHECK(abs(frames - expected) <= 1 && irregular == 0, "scheduler: %d frames in %d ticks, %d irregular", frames, expected, irregular);
+
+  // a late loop skips the missed ticks instead of catching up
+  uint32_t overruns = tickOverruns;
+  hostAdvanceMicros(35000);
+  long rendered = frameCounter;
+  runLoop(5);
+  CHECK(frameCounter == rendered + 1 && tickOverruns == overruns + 1, "scheduler: missed ticks not skipped");
+  rendered = frameCounter;
+  runLoop(100);
+  CHECK(frameCounter - rendered <= 11, "scheduler: burst after missed ticks");
+
+  initialConfig();
+  inputBegin();
+  printf("scheduler: ok\n");
+}
+
+static void checkWeb() {
+  config.mode = 3;
+  config.pixels = 144;
+  strip.updateLength(config.pixels);
+  runLoop(100);
+
+  // a request that takes 4 ms every 50 ms, a loop every 200 us
+  webDelay = 0;
+  long rendered = frameCounter;
+  uint32_t start = micros();
+  for (int step = 0; step < 5000; step++) {
+    if (step % 250 == 0)
+      server.hostQueue(HTTP_GET, "/monitor", 4000);
+    hostAdvanceMicros(200);
+    loop();
+  }
+  int frames = frameCounter - rendered, expected = (micros() - start) / 10000;
+  CHECK(frames >= expected - 1 && server.hostQueued() == 0, "web: %d frames in %d ticks, %u requests left", frames, expected, (unsigned)server.hostQueued());
+  // the web server starts at least WEB_BUDGET before the tick
+  CHECK(webDelay <= 4000 - 3000 + 200, "web: frame delayed by %u us", webDelay);
+  printf("web: %d frames in %d ticks with 20 requests, longest delay %u us\n", frames, expected, webDelay);
+
+  // a request that takes longer than the time between ticks delays the next frame by the rest of it
+  webDelay = 0;
+  server.hostQueue(HTTP_GET, "/monitor", 25000);
+  runLoop(100);
+  CHECK(server.hostQueued() == 0, "web: request held off for good");
+  CHECK(webDelay >= 15000 && webDelay <= 25000, "web: long request delayed a frame by %u us", webDelay);
+
+  initialConfig();
+  strip.updateLength(config.pixels);
+  printf("web: ok\n");
+}
+
+static void checkDirty() {
+  uint8_t slots[DMX_SLOTS] = { 10, 20, 30, 255 };
+
+  config.mode = 1;
+  config.pixels = 144;
+  strip.updateLength(config.pixels);
+  uint32_t shown = showTransfers, skipped = showSkipped;
+  for (int i = 0; i < 50; i++)
+    mode1<FormatRGB>(config.universe, DMX_SLOTS, 0, slots);
+  CHECK(showTransfers == shown + 1 && showSkipped == skipped + 49, "dirty: unchanged frames transmitted");
+
+  // new data, a new brightness or a new length are transmitted
+  slots[1] = 21;
+  mode1<FormatRGB>(config.universe, DMX_SLOTS, 0, slots);
+  strip.setBrightness(100);
+  mode1<FormatRGB>(config.universe, DMX_SLOTS, 0, slots);
+  strip.updateLength(100);
+  mode1<FormatRGB>(config.universe, DMX_SLOTS, 0, slots);
+  CHECK(showTransfers == shown + 4, "dirty: changed frames not transmitted");
+  CHECK(strip.getPixelColor(99) == 0x0a151e, "dirty: wrong color");
+
+  strip.setBrightness(255);
+  initialConfig();
+  strip.updateLength(config.pixels);
+  printf("dirty: ok\n");
+}
+
+static void checkLut() {
+  uint8_t pixels[2 * PIXEL_BYTES];
+
+  // two LED frames, the brightness bytes are never changed
+  config.gamma = 0;
+  lutBuild();
+  memcpy(pixels, "\xff\x00\x40\x80\xe1\xc0\xff\x01", 8);
+  lutApply(pixels, 2);
+  CHECK(!memcmp(pixels, "\xff\x00\x40\x80\xe1\xc0\xff\x01", 8), "lut: not the identity");
+
+  config.gamma = 1;
+  lutBuild();
+  lutApply(pixels, 2);
+  CHECK(pixels[0] == 0xff && pixels[1] == 0 && pixels[3] == 37 && pixels[4] == 0xe1 && pixels[6] == 255 && pixels[7] == 0,
+        "lut: gamma %d %d %d %d", pixels[1], pixels[3], pixels[6], pixels[7]);
+
+  // brightness and white balance on linear values
+  config.gamma = 0;
+  config.brightness = 128;
+  config.red = 0;
+  config.blue = 128;
+  lutBuild();
+  memset(pixels, 255, 8);
+  lutApply(pixels, 2);
+  CHECK(pixels[R_OFFSET] == 0 && pixels[G_OFFSET] == 128 && pixels[B_OFFSET] == 64 && pixels[PIXEL_BYTES + B_OFFSET] == 64 && pixels[0] == 0xff,
+        "lut: scaled to %d %d %d", pixels[R_OFFSET], pixels[G_OFFSET], pixels[B_OFFSET]);
+
+  // the strip transmits the corrected values, the pixels stay linear, new tables are transmitted again
+  config.pixels = 1;
+  strip.updateLength(config.pixels);
+  fillPixels(0, 1, 200, 100, 50);
+  outputFlush();
+  uint8_t sink = SPI.sink;
+  uint32_t shown = showTransfers;
+  showPixels();
+  outputFlush();
+  CHECK((uint8_t)(sink ^ SPI.sink) == (0xff ^ 0 ^ 50 ^ 13), "lut: transmitted %02x", sink ^ SPI.sink);
+  CHECK(strip.getPixelColor(0) == 0xc86432, "lut: pixels changed to %06x", strip.getPixelColor(0));
+  showPixels();
+  lutBuild();
+  showPixels();
+  CHECK(showTransfers == shown + 2, "lut: %u transfers", showTransfers - shown);
+
+  // a quarter step is dithered to one step in about every fourth frame, the error bytes follow the strip length
+  config.brightness = 64;
+  config.red = config.green = config.blue = 255;
+  config.dither = 1;
+  lutBuild();
+  int sum = 0, highest = 0;
+  for (int frame = 0; frame < 256; frame++) {
+    memset(pixels, 1, 8);
+    lutApply(pixels, 2);
+    sum += pixels[1];
+    highest = max(highest, (int)pixels[1]);
+  }
+  CHECK(lutDithering() && sum >= 63 && sum <= 65 && highest == 1, "lut: dithered to %d in 256 frames", sum);
+  memset(pixels, 255, 8);
+  lutApply(pixels, 1);
+  CHECK(pixels[1] == 64 && pixels[2] == 64 && pixels[3] == 64, "lut: dithered full scale %d", pixels[1]);
+
+  // dithered frames are transmitted even when they did not change
+  shown = showTransfers;
+  showPixels();
+  showPixels();
+  CHECK(showTransfers == shown + 2, "lut: %u dithered transfers", showTransfers - shown);
+
+  initialConfig();
+  lutBuild();
+  strip.updateLength(config.pixels);
+  printf("lut: ok\n");
+}
+
+static void checkOutput() {
+  // the strip buffer holds the LED frames as they go out, the driver adds the start and end frames
+  strip.updateLength(3);
+  strip.setPixelColor(1, 0x102030);
+  strip.setBrightness(128);
+  const uint8_t *leds = strip.getPixels();
+  CHECK(!memcmp(leds, "\xf0\0\0\0\xf0\x30\x10\x20\xf0\0\0\0", 12), "output: LED frames %02x %02x %02x %02x", leds[0], leds[5], leds[6], leds[7]);
+  uint64_t written = SPI.bytes;
+  showPixels();
+  outputFlush();
+  CHECK(SPI.bytes - written == DOTSTAR_FRAME_BYTES(3), "output: %u bytes on the wire", (unsigned)(SPI.bytes - written));
+  strip.setBrightness(255);
+
+  config.pixels = 143;
+  strip.updateLength(config.pixels);
+  fillPixels(0, config.pixels, 10, 20, 30);
+  uint8_t frame[4];
+  lutEncode(strip.getPixels(), frame, 1);
+
+  // only the first chunk goes out right away, the next frame can be rendered meanwhile
+  outputFlush();
+  uint8_t sink = SPI.sink;
+  uint64_t bytes = SPI.bytes;
+  showPixels();
+  CHECK(outputBusy() && SPI.bytes - bytes == OUTPUT_CHUNK, "output: %u bytes sent at once", (unsigned)(SPI.bytes - bytes));
+  fillPixels(0, config.pixels, 0, 0, 0);
+
+  // the loop refills the FIFO, 4 + 4 * 143 + 4 + 8 bytes take 588 us at 8 MHz
+  int polls = 0;
+  while (outputBusy() && polls < 10000) {
+    hostAdvanceMicros(1);
+    outputPoll();
+    polls++;
+  }
+  outputPoll();
+  CHECK(!outputBusy() && SPI.bytes - bytes == 588, "output: %u bytes in %d polls", (unsigned)(SPI.bytes - bytes), polls);
+  CHECK((uint8_t)(sink ^ SPI.sink) == (frame[0] ^ frame[1] ^ frame[2] ^ frame[3]), "output: transmitted %02x", sink ^ SPI.sink);
+  CHECK(outputTime >= 588 && outputTime <= 600, "output: %u us on the wire", outputTime);
+
+  // a frame that is sent while the previous one is on the wire waits for it
+  uint32_t waits = outputWaits;
+  showPixels();
+  fillPixels(0, config.pixels, 1, 2, 3);
+  showPixels();
+  outputFlush();
+  CHECK(outputWaits == waits + 1 && !outputBusy(), "output: %u waits", outputWaits - waits);
+
+  // three slices on three outputs, on the wire at the same time
+  static const uint8_t pins[OUTPUT_COUNT][2] = { { 0, 0 }, { OUTPUT1_CLOCK, OUTPUT1_DATA }, { OUTPUT2_CLOCK, OUTPUT2_DATA } };
+  static const uint16_t slices[OUTPUT_COUNT] = { 73, 40, 30 };
+  CHECK(hostPinMode[OUTPUT1_DATA] == INPUT && hostPinMode[OUTPUT2_CLOCK] == INPUT, "output: pins without a slice driven");
+  config.gamma = 0;
+  config.slice1 = slices[1];
+  config.slice2 = slices[2];
+  lutBuild();
+  for (int pixel = 0; pixel < config.pixels; pixel++)
+    strip.setPixelColor(pixel, pixel * 0x010203);
+  HostGpioWatch *watch[OUTPUT_COUNT] = { NULL };
+  uint64_t before[OUTPUT_COUNT];
+  uint8_t sinks[OUTPUT_COUNT];
+  for (int k = 1; k < OUTPUT_COUNT; k++) {
+    watch[k] = hostGpioWatch(pins[k][0], pins[k][1]);
+    before[k] = watch[k]->bytes;
+    sinks[k] = watch[k]->sink;
+  }
+  bytes = SPI.bytes;
+  sinks[0] = SPI.sink;
+  showPixels();
+  polls = 0;
+  while (outputBusy() && polls < 10000) {
+    hostAdvanceMicros(1);
+    outputPoll();
+    polls++;
+  }
+  outputPoll();
+
+  const uint8_t *p = strip.getPixels();
+  uint32_t longest = 0;
+  for (int k = 0; k < OUTPUT_COUNT; k++) {
+    uint32_t length = 4 + PIXEL_BYTES * slices[k] + 4 + slices[k] / 16;
+    uint8_t expected = ((length - PIXEL_BYTES * slices[k] - 4) & 1 ? 0xFF : 0);
+    for (int i = 0; i < PIXEL_BYTES * slices[k]; i++)
+      expected ^= *p++;
+    uint64_t sent = (k ? watch[k]->bytes - before[k] : SPI.bytes - bytes);
+    uint8_t sink = (k ? watch[k]->sink ^ sinks[k] : SPI.sink ^ sinks[0]);
+    CHECK(outputSlice(k) == slices[k] && sent == length && sink == expected,
+          "output %d: %u pixels, %u of %u bytes, transmitted %02x instead of %02x", k, outputSlice(k), (unsigned)sent, length, sink, expected);
+    longest = max(longest, length);
+  }
+  // the SPI output is the longest at 8 MHz, the others are bit-banged meanwhile
+  CHECK(outputTime >= longest && outputTime < longest + 60, "output: %u us for %u bytes on the longest output", outputTime, longest);
+  CHECK(hostPinMode[OUTPUT1_DATA] == OUTPUT && hostPinMode[OUTPUT2_CLOCK] == OUTPUT, "output: pins of the slices not driven");
+
+  // the pins are released with the slice
+  config.slice2 = 0;
+  strip.setPixelColor(0, 0x010101);
+  showPixels();
+  outputFlush();
+  CHECK(hostPinMode[OUTPUT1_CLOCK] == OUTPUT && hostPinMode[OUTPUT2_DATA] == INPUT && hostPinMode[OUTPUT2_CLOCK] == INPUT,
+        "output: pins of output 2 still driven");
+  config.slice1 = 0;
+
+  initialConfig();
+  lutBuild();
+  strip.updateLength(config.pixels);
+  printf("output: ok\n");
+}
+
+static void checkHdr() {
+  uint8_t frame[4];
+  int worst = 0, worstDim = 0;
+
+  // every 16-bit value within about half a PWM step of its level, which is fine for dim colors
+  for (uint32_t v = 0; v < 65536; v++) {
+    apa102Encode(v, v / 2, 0, frame);
+    int level = frame[0] & 0x1F;
+    int step = level * 65535 / (APA102_LEVELS * 255);
+    int diff = abs((int)apa102Decode(frame, R_OFFSET) - (int)v);
+    CHECK((frame[0] & 0xE0) == 0xE0 && level >= 1 && diff <= step / 2 + 2 && frame[B_OFFSET] == 0,
+          "hdr: %u encoded as %02x %02x %02x %02x", v, frame[0], frame[1], frame[2], frame[3]);
+    worst = max(worst, diff);
+    if (v < 2048)
+      worstDim = max(worstDim, diff);
+  }
+  CHECK(worstDim <= 5, "hdr: dim colors off by %d", worstDim);
+  printf("hdr: max deviation %d, %d below 2048 where 8-bit output is off by up to 128\n", worst, worstDim);
+
+  // mode 13 with linear output, four bytes per pixel as with the 8-bit modes
+  config.gamma = 0;
+  config.leds = 3;
+  config.pixels = 20;
+  strip.updateLength(config.pixels);
+  modeSelect();
+  lutBuild();
+  CHECK(modeFootprint(13) == 120 && modePixelChannels(13) == 6 && modePixelChannels(1) == 3, "hdr: footprint %u", modeFootprint(13));
+
+  uint8_t slots[DMX_SLOTS] = { 0x12, 0x34, 0x00, 0x05, 0xff, 0xff, 0x00, 0x10 };
+  outputFlush();
+  uint64_t bytes = SPI.bytes;
+  mode13<FormatRGB>(config.universe, DMX_SLOTS, 0, slots);
+  outputFlush();
+  CHECK(SPI.bytes - bytes == 4 + 4 * 20 + 4 + 20 / 16, "hdr: %u bytes transmitted", (unsigned)(SPI.bytes - bytes));
+  const uint16_t *hdr = hdrPixels();
+  CHECK(hdr[0] == 0x1234 && hdr[1] == 5 && hdr[2] == 0xffff && hdr[3] == 0x0010 && hdr[5] == 0, "hdr: pixels %04x %04x %04x", hdr[0], hdr[1], hdr[2]);
+  CHECK(strip.getPixelColor(0) == 0x1200ff && strip.getPixelColor(1) == 0, "hdr: strip %06x", strip.getPixelColor(0));
+
+  initialConfig();
+  modeSelect();
+  lutBuild();
+  strip.updateLength(config.pixels);
+  printf("hdr: ok\n");
+}
+
+static void checkArena() {
+  uint8_t *pixels = strip.getPixels();
+  uint32_t heap = ESP.getFreeHeap();
+  CHECK(pixels == arena.strip && strip.capacity() == MAX_PIXELS, "arena: strip not in the arena");
+
+  // every length up to the arena, the pixels stay where they are
+  static const uint16_t lengths[] = { 1, 300, MAX_PIXELS, 17 };
+  for (unsigned k = 0; k < sizeof(lengths) / sizeof(lengths[0]); k++) {
+    uint16_t n = lengths[k];
+    CHECK(strip.updateLength(n) && strip.numPixels() == n && strip.getPixels() == pixels, "arena: length %u", n);
+    strip.setPixelColor(n - 1, 0x102030);
+    showPixels();
+    hdrPixels();
+    hdrShow();
+  }
+  outputFlush();
+  CHECK(!strip.updateLength(MAX_PIXELS + 1) && strip.numPixels() == MAX_PIXELS, "arena: %u pixels beyond the arena", strip.numPixels());
+  CHECK(outputFrames(MAX_PIXELS + 1) == NULL && outputFrames(MAX_PIXELS) != NULL, "arena: output frames beyond the arena");
+  CHECK(ESP.getFreeHeap() == heap, "arena: %d bytes of heap used by resizing", (int)(heap - ESP.getFreeHeap()));
+
+  // the same length in the configuration keeps the pixels
+  config.pixels = 50;
+  updateNeopixelStrip();
+  strip.setPixelColor(3, 0x0a0b0c);
+  updateNeopixelStrip();
+  CHECK(strip.getPixelColor(3) == 0x0a0b0c, "arena: strip resized without a change");
+  config.pixels = MAX_PIXELS + 100;
+  updateNeopixelStrip();
+  strip.setPixelColor(3, 0x0a0b0c);
+  updateNeopixelStrip();
+  CHECK(strip.numPixels() == MAX_PIXELS && strip.getPixelColor(3) == 0x0a0b0c, "arena: strip beyond the arena resized again");
+
+  // shown, hdr and dither share their memory, a frame after mode 13 is transmitted even if it did not change
+  config.pixels = 20;
+  updateNeopixelStrip();
+  strip.setPixelColor(0, 0x102030);
+  showPixels();
+  uint32_t transfers = showTransfers;
+  memcpy(hdrPixels(), strip.getPixels(), PIXEL_BYTES * 20);
+  showPixels();
+  showPixels();
+  CHECK(showTransfers == transfers + 1, "arena: %u transfers after mode 13", showTransfers - transfers);
+
+  // and the dither fractions are written again, a quarter step is sent in every fourth frame
+  config.gamma = 0;
+  config.brightness = 64;
+  config.dither = 1;
+  lutBuild();
+  memset(hdrPixels(), 0xFF, sizeof(arena.hdr));
+  uint8_t frame[PIXEL_BYTES];
+  int sum = 0;
+  for (int k = 0; k < 256; k++) {
+    memset(frame, 1, sizeof(frame));
+    lutApply(frame, 1);
+    sum += frame[1];
+  }
+  CHECK(sum >= 63 && sum <= 65, "arena: dithered to %d after mode 13", sum);
+  initialConfig();
+  lutBuild();
+
+  heapSample();
+  CHECK(heapMin <= ESP.getFreeHeap(), "arena: heap low-water %u", heapMin);
+
+  initialConfig();
+  updateNeopixelStrip();
+  printf("arena: %u bytes for %u pixels, ok\n", (unsigned)sizeof(arena), MAX_PIXELS);
+}
+
+static void checkInterpolate() {
+  uint8_t slots[DMX_SLOTS];
+  bool fading;
+
+  config.mode = 0;
+  config.leds = 3;
+  config.pixels = 10;
+  config.interpolate = INTERPOLATE_LINEAR;
+  strip.updateLength(config.pixels);
+  inputBegin();
+
+  memset(slots, 0, sizeof(slots));
+  e131SendData(config.universe, 1, slots, 512);
+  inputPoll();
+  hostAdvanceMicros(40000);
+  memset(slots, 200, sizeof(slots));
+  e131SendData(config.universe, 2, slots, 512);
+  inputPoll();
+
+  // smoothstep of 0, 1/4, 1/2, 3/4 is 0, 5/32, 1/2, 27/32
+  static const int linear[4] = { 0, 50, 100, 150 }, smooth[4] = { 0, 31, 100, 168 };
+  for (int i = 0; i < 4; i++) {
+    config.interpolate = INTERPOLATE_LINEAR;
+    const DmxFrame *frame = interpolateFrame(510, &fading);
+    CHECK(fading && abs(frame->data[100] - linear[i]) <= 1 && frame->length == 510, "interpolate: linear %d at %d ms", frame->data[100], 10 * i);
+    config.interpolate = INTERPOLATE_SMOOTH;
+    frame = interpolateFrame(510, &fading);
+    CHECK(fading && abs(frame->data[100] - smooth[i]) <= 1, "interpolate: smooth %d at %d ms", frame->data[100], 10 * i);
+    frame = interpolateFrame(12, &fading);
+    CHECK(frame->length == 12 && abs(frame->data[11] - smooth[i]) <= 1, "interpolate: parameter channels");
+    hostAdvanceMicros(10000);
+  }
+  CHECK(interpolateFrame(510, &fading) == inputFrame() && !fading, "interpolate: current frame not reached");
+
+  // no blending over a gap in the stream
+  hostAdvanceMicros(300000);
+  memset(slots, 10, sizeof(slots));
+  e131SendData(config.universe, 3, slots, 512);
+  inputPoll();
+  CHECK(interpolateFrame(510, &fading) == inputFrame() && !fading, "interpolate: blended over a gap");
+
+  // the pixels of a long strip do not fit the buffer, the parameters of a mode do
+  config.universes = 3;
+  for (int k = 0; k < 2; k++) {
+    hostAdvanceMicros(40000);
+    memset(slots, 100 * k, sizeof(slots));
+    for (int u = 0; u < 3; u++) {
+      e131SendData(config.universe + u, 10 + k, slots, 512);
+      inputPoll();
+    }
+  }
+  hostAdvanceMicros(20000);
+  uint16_t length = inputFrame()->length;
+  CHECK(length > INTERPOLATE_SLOTS && interpolateFrame(length, &fading) == inputFrame() && !fading, "interpolate: %u channels blended", length);
+  CHECK(interpolateFrame(12, &fading) != inputFrame() && fading, "interpolate: parameters of a long frame");
+  config.universes = 1;
+
+  // the 16-bit colors of mode 13 cross from 0x10ff to 0x1100 without a dip
+  config.mode = 13;
+  config.offset = 1;
+  hostAdvanceMicros(300000);
+  memset(slots, 0, sizeof(slots));
+  slots[1] = 0x10, slots[2] = 0xff;
+  e131SendData(config.universe, 6, slots, 512);
+  inputPoll();
+  hostAdvanceMicros(40000);
+  slots[1] = 0x11, slots[2] = 0x00;
+  e131SendData(config.universe, 7, slots, 512);
+  inputPoll();
+  hostAdvanceMicros(20000);
+  const DmxFrame *frame = interpolateFrame(510, &fading);
+  uint16_t v = (frame->data[1] << 8) | frame->data[2];
+  CHECK(fading && (v == 0x10ff || v == 0x1100), "interpolate: 16-bit value %04x at half way", v);
+  config.mode = 0;
+  config.offset = 0;
+
+  // mode 0 is rendered on every tick while fading
+  config.interpolate = INTERPOLATE_LINEAR;
+  runLoop(300);
+  memset(slots, 110, sizeof(slots));
+  e131SendData(config.universe, 4, slots, 512);
+  uint32_t shown = runLoop(40);
+  memset(slots, 210, sizeof(slots));
+  e131SendData(config.universe, 5, slots, 512);
+  uint32_t faded = runLoop(100);
+  CHECK(shown == 1 && faded >= 4 && faded <= 6, "interpolate: %u and %u frames shown while fading", shown, faded);
+  CHECK(strip.getPixelColor(9) == 0xd2d2d2, "interpolate: final color %06x", strip.getPixelColor(9));
+
+  initialConfig();
+  inputBegin();
+  printf("interpolate: ok\n");
+}
+
+static void checkModes() {
+  static uint8_t slots[FRAME_SLOTS];
+  static DmxFrame frame;
+  memset(&frame, 0, sizeof(frame));
+  memset(slots, 0, sizeof(slots));
+  frame.universe = config.universe;
+  frame.data = slots;
+
+  config.leds = 4;
+  config.white = 1;
+  config.position = 2;
+  config.pixels = 100;
+  strip.updateLength(config.pixels);
+  modeSelect();
+  CHECK(modeFootprint(0) == 400 && modeFootprint(1) == 5 && modeFootprint(3) == 16 && modeFootprint(11) == 3,
+        "modes: footprints %u %u %u %u", modeFootprint(0), modeFootprint(1), modeFootprint(3), modeFootprint(11));
+  config.white = 0;
+  modeSelect();
+  CHECK(modeFootprint(0) == 300 && modeFootprint(3) == 14, "modes: RGB footprints");
+  CHECK(modeAnimated(12) && !modeAnimated(11) && !modeAnimated(MODE_COUNT) && !modeInfo(-1), "modes: lookup");
+
+  config.offset = 10;
+  frame.length = 309;
+  CHECK(!modeRender(0, &frame), "modes: short frame rendered");
+  frame.length = 310;
+  CHECK(modeRender(0, &frame), "modes: frame not rendered");
+  frame.universe++;
+  CHECK(!modeRender(0, &frame), "modes: other universe rendered");
+  frame.universe--;
+  CHECK(!modeRender(MODE_COUNT, &frame), "modes: unknown mode rendered");
+
+  // the white channel is mixed into the colors, the RGB kernel reads the next pixel from there
+  static const uint8_t pixels[] = { 10, 20, 30, 100, 200, 20, 30, 100 };
+  memcpy(frame.data + config.offset, pixels, sizeof(pixels));
+  frame.length = 410;
+  config.white = 1;
+  modeSelect();
+  CHECK(modeRender(0, &frame) && strip.getPixelColor(0) == 0x6e7882 && strip.getPixelColor(1) == 0xff7882,
+        "modes: RGBW pixels %06x %06x", strip.getPixelColor(0), strip.getPixelColor(1));
+  config.white = 0;
+  modeSelect();
+  CHECK(modeRender(0, &frame) && strip.getPixelColor(0) == 0x0a141e && strip.getPixelColor(1) == 0x64c814,
+        "modes: RGB pixels %06x %06x", strip.getPixelColor(0), strip.getPixelColor(1));
+
+  server.hostResponse = HostResponse();
+  handleModes();
+  const std::string &body = server.hostResponse.body;
+  CHECK(body.find("{\"mode\":2,\"name\":\"two color mixing\",\"animated\":false,\"repeat\":\"once\",\"rgb\":8,\"rgbw\":10,"
+                  "\"channels\":[\"red1\",\"green1\",\"blue1\",\"white1\",\"red2\"") != std::string::npos &&
+        body.find("\"mode\":13,") != std::string::npos && body.find("\"mode\":14,") == std::string::npos,
+        "modes: response %s", body.c_str());
+  CHECK(body.compare(0, 10, "[{\"mode\":0") == 0 && body.compare(body.size() - 4, 4, "\"]}]") == 0, "modes: bounds %s", body.c_str());
+  server.hostReset();
+  uint32_t allocs = hostAllocCount;
+  handleModes();
+  CHECK(hostAllocCount == allocs, "modes: /modes made %u allocations", hostAllocCount - allocs);
+
+  initialConfig();
+  strip.updateLength(config.pixels);
+  printf("modes: ok\n");
+}
+
+static void checkStats() {
+  uint8_t slots[DMX_SLOTS] = { 0 };
+  static const uint8_t sequence[] = { 1, 2, 3, 5, 5, 4, 6, 7, 8, 9, 10, 11 };
+
+  config.universes = 2;
+  inputBegin();
+  CHECK(packetTotal == 0 || universeStats[0].packets == 0, "stats: not reset");
+  uint32_t packets = packetTotal;
+
+  // universe 1 at 40 Hz with one packet 15 ms late, universe 2 only every other frame and it is
+  // already quiet for 25 ms when the rates are taken
+  for (unsigned i = 0; i < sizeof(sequence); i++) {
+    hostAdvanceMicros(i == 8 ? 40000 : i == 9 ? 10000 : 25000);
+    e131SendData(config.universe, sequence[i], slots, 512);
+    inputPoll();
+    if (i % 2 == 0) {
+      e131SendData(config.universe + 1, i, slots, 512);
+      inputPoll();
+    }
+  }
+  const UniverseStats *s = &universeStats[0];
+  CHECK(packetTotal - packets == 18 && s->packets == 12 && universeStats[1].packets == 6, "stats: packets %u", packetTotal - packets);
+  CHECK(s->lost == 0 && s->duplicates == 1 && s->reordered == 1, "stats: lost %u duplicates %u reordered %u", s->lost, s->duplicates, s->reordered);
+  CHECK(universeStats[1].lost == 5, "stats: lost %u on universe 2", universeStats[1].lost);
+  CHECK(s->jitter[0] == 9 && s->jitter[4] == 2 && s->interval > 24000 && s->interval < 26000,
+        "stats: jitter %u %u %u %u %u, interval %d", s->jitter[0], s->jitter[1], s->jitter[2], s->jitter[3], s->jitter[4], s->interval);
+  CHECK(fabs(statsPacketRate(0) - 40) < 0.5 && statsPacketRate(1) > 17 && statsPacketRate(1) < 20.5, "stats: rates %.1f %.1f", statsPacketRate(0), statsPacketRate(1));
+  CHECK(frameTotal > 0 && statsFrameRate() > 0, "stats: no frames");
+
+  server.hostResponse = HostResponse();
+  handleStats();
+  const std::string &body = server.hostResponse.body;
+  CHECK(server.hostResponse.code == 200 && body.find("\"universes\":[{\"universe\":1,\"packets\":12,\"lost\":0,\"duplicates\":1") != std::string::npos &&
+        body.find("{\"universe\":2,") != std::string::npos && body.compare(0, 10, "{\"uptime\":") == 0 && body.compare(body.size() - 4, 4, "]}]}") == 0,
+        "stats: response %s", body.c_str());
+  server.hostReset();
+  uint32_t allocs = hostAllocCount;
+  handleStats();
+  CHECK(hostAllocCount == allocs, "stats: /stats made %u allocations", hostAllocCount - allocs);
+
+  // a stream that stopped reports no rate
+  hostAdvanceMicros(2000000);
+  CHECK(statsPacketRate(0) < 6, "stats: stopped stream at %.1f packets per second", statsPacketRate(0));
+
+  initialConfig();
+  inputBegin();
+  printf("stats: ok\n");
+}
+
+static void checkStatus() {
+  char buf[64];
+  JsonWriter json(buf, sizeof(buf));
+  json.beginObject();
+  json.add("name", "a \"b\"\\\n");
+  json.beginArray("list");
+  json.add(NULL, -3);
+  json.add(NULL, 2.5, 1);
+  json.add(NULL, true);
+  json.endArray();
+  json.endObject();
+  CHECK(!json.overflow() && !strcmp(buf, "{\"name\":\"a \\\"b\\\"\\\\\\u000a\",\"list\":[-3,2.5,true]}") && json.length() == strlen(buf),
+        "status: writer %s", buf);
+  JsonWriter small(buf, 12);
+  small.beginObject();
+  small.add("pixels", 144);
+  small.add("mode", 1);
+  small.endObject();
+  CHECK(small.overflow() && !strcmp(buf, "{\"pixels\":"), "status: overflow %s", buf);
+
+  // the response is printed on the stack, the second one is captured into the memory of the first
+  config.pixels = 77;
+  handleStatusJSON();
+  server.hostReset();
+  uint32_t allocs = hostAllocCount;
+  handleStatusJSON();
+  CHECK(hostAllocCount == allocs, "status: /json made %u allocations", hostAllocCount - allocs);
+  StaticJsonBuffer<1024> jsonBuffer;
+  JsonObject &root = jsonBuffer.parseObject(server.hostResponse.body.c_str());
+  CHECK(server.hostResponse.code == 200 && root.success() && (int)root["pixels"] == 77 && (long)root["packets"] == (long)packetTotal &&
+        root.containsKey("version") && root.containsKey("webdelay"), "status: /json %s", server.hostResponse.body.c_str());
+
+  server.hostReset();
+  handleStatusBin();
+  StatusRecord status;
+  memcpy(&status, server.hostResponse.body.data(), min(sizeof(status), server.hostResponse.body.size()));
+  CHECK(sizeof(StatusRecord) == 60 && server.hostResponse.body.size() == sizeof(status) && server.hostResponse.contentType == "application/octet-stream",
+        "status: /status.bin of %u bytes", (unsigned)server.hostResponse.body.size());
+  CHECK(status.magic == STATUS_MAGIC && status.version == STATUS_VERSION && status.length == 60 && status.pixels == 77 &&
+        status.packets == packetTotal && status.heapMin == heapMin, "status: record %04x %u %u", status.magic, status.version, status.pixels);
+
+  initialConfig();
+  printf("status: ok\n");
+}
+
+static int logEvaluated = 0;
+
+static int logArgument() {
+  return ++logEvaluated;
+}
+
+static void checkLog() {
+  logFlush();
+
+  // compiled out, the arguments are not evaluated
+  LOG(LOG_LEVEL + 1, LOG_WEB, "%d", logArgument());
+  LOG(LOG_ERROR, ~LOG_CATEGORIES & 0xFF, "%d", logArgument());
+  CHECK(logEvaluated == 0, "log: disabled message evaluated");
+
+#if LOG_LEVEL >= LOG_INFO
+  uint32_t dropped = logDropped, bytes = hostSerialBytes;
+
+  // nothing goes out while the serial port has no room
+  hostSerialRoom = 0;
+  for (int i = 0; i < 100; i++)
+    LOG_I(LOG_WEB, "message %d %s", i, "padding to make the line about sixty bytes");
+  logDrain();
+  CHECK(hostSerialBytes == bytes, "log: %u bytes written without room", hostSerialBytes - bytes);
+
+  // only whole lines are left in the ring, the newest last
+  const char *first, *second;
+  size_t firstLength, secondLength;
+  logContents(&first, &firstLength, &second, &secondLength);
+  std::string contents = std::string(first, firstLength) + std::string(second, secondLength);
+  CHECK(contents.size() <= LOG_RING && contents.size() > LOG_RING - LOG_LINE && isdigit(contents[0]) && contents.back() == '\n',
+        "log: ring of %u bytes", (unsigned)contents.size());
+  size_t last = contents.rfind('\n', contents.size() - 2) + 1;
+  CHECK(contents.find(" I web: message 99 padding", last) != std::string::npos && contents.find("message 0 ") == std::string::npos,
+        "log: last line %s", contents.c_str() + last);
+  CHECK(logDropped > dropped, "log: no lines dropped");
+
+  // /log is the ring as it is
+  server.hostReset();
+  handleLog();
+  CHECK(server.hostResponse.code == 200 && server.hostResponse.body == contents, "log: /log of %u bytes", (unsigned)server.hostResponse.body.size());
+
+  // with room the ring drains
+  hostSerialRoom = 128;
+  logDrain();
+  CHECK(hostSerialBytes - bytes == contents.size(), "log: drained %u of %u bytes", hostSerialBytes - bytes, (unsigned)contents.size());
+#endif
+  printf("log: ok\n");
+}
+
+// put a file into the in-memory SPIFFS
+static void writeFile(const char *path, const char *content) {
+  File f = SPIFFS.open(path, "w");
+  f.write((const uint8_t *)content, strlen(content));
+  f.close();
+}
+
+static void checkConfigStore() {
+  File f;
+  configErase();
+  SPIFFS.remove("/config.json");
+  initialConfig();
+  Config defaults = config;
+  CHECK(!loadConfig(), "config: loaded from nothing");
+
+  // only changes are written, to A and B in turn
+  uint32_t writes = SPIFFS.hostWrites;
+  CHECK(saveConfig() && saveConfig() && SPIFFS.hostWrites == writes + 1 && SPIFFS.exists("/config.a"), "config: %u writes", SPIFFS.hostWrites - writes);
+  config.pixels = 300;
+  CHECK(saveConfig() && SPIFFS.hostWrites == writes + 2 && SPIFFS.exists("/config.b"), "config: change not written");
+  config.mode = 5;
+  saveConfig();
+  CHECK(SPIFFS.hostWrites == writes + 3, "config: %u writes", SPIFFS.hostWrites - writes);
+  Config saved = config;
+
+  // the newest record wins, A now
+  config = defaults;
+  CHECK(loadConfig() && !memcmp(&config, &saved, sizeof(Config)), "config: pixels %d mode %d after load", config.pixels, config.mode);
+
+  // a write that was cut off by a power loss goes to B, A is still there
+  f = SPIFFS.open("/config.b", "w");
+  f.write((const uint8_t *)"CF\x01", 3);
+  f.close();
+  config = defaults;
+  CHECK(loadConfig() && !memcmp(&config, &saved, sizeof(Config)), "config: half written record");
+
+  // a flipped bit in A falls back to B, which has the record before
+  config.mode = 6;
+  saveConfig();
+  f = SPIFFS.open("/config.b", "r");
+  uint8_t buf[256];
+  size_t size = f.read(buf, sizeof(buf));
+  f.close();
+  buf[20] ^= 0x04;
+  f = SPIFFS.open("/config.b", "w");
+  f.write(buf, size);
+  f.close();
+  config = defaults;
+  CHECK(loadConfig() && config.mode == 5 && config.pixels == 300, "config: damaged record, mode %d", config.mode);
+
+  // a record of an older firmware without the slices, they keep their defaults
+  ConfigHeader header = { CONFIG_MAGIC, 0, (uint8_t)offsetof(Config, slice1), 1000 };
+  Config older = saved;
+  older.universe = 9;
+  memcpy(buf, &header, sizeof(header));
+  memcpy(buf + sizeof(header), &older, header.length);
+  uint32_t crc = configCrc(buf, sizeof(header) + header.length);
+  memcpy(buf + sizeof(header) + header.length, &crc, 4);
+  f = SPIFFS.open("/config.b", "w");
+  f.write(buf, sizeof(header) + header.length + 4);
+  f.close();
+  config = defaults;
+  config.slice1 = 7;
+  CHECK(loadConfig() && config.universe == 9 && config.slice1 == 7, "config: older record, universe %d slice1 %d", config.universe, config.slice1);
+
+  // the same fields with the current version do not agree with its length, A is used
+  header.version = CONFIG_VERSION;
+  memcpy(buf, &header, sizeof(header));
+  crc = configCrc(buf, sizeof(header) + header.length);
+  memcpy(buf + sizeof(header) + header.length, &crc, 4);
+  f = SPIFFS.open("/config.b", "w");
+  f.write(buf, sizeof(header) + header.length + 4);
+  f.close();
+  config = defaults;
+  CHECK(loadConfig() && config.universe == saved.universe && config.mode == 5, "config: short record of this version, universe %d", config.universe);
+
+  // without a record the JSON file is imported once and written as a record
+  configErase();
+  writeFile("/config.json", "{\"universe\": 4, \"pixels\": 60}");
+  config = defaults;
+  writes = SPIFFS.hostWrites;
+  CHECK(loadConfig() && config.universe == 4 && config.pixels == 60 && SPIFFS.hostWrites == writes + 1, "config: import");
+  config = defaults;
+  CHECK(loadConfig() && config.universe == 4 && SPIFFS.hostWrites == writes + 1, "config: imported again");
+
+  server.hostReset();
+  handleConfigExport();
+  StaticJsonBuffer<512> jsonBuffer;
+  JsonObject &root = jsonBuffer.parseObject(server.hostResponse.body.c_str());
+  CHECK(root.success() && (int)root["universe"] == 4 && (int)root["pixels"] == 60 && root.containsKey("slice2"), "config: export %s",
+        server.hostResponse.body.c_str());
+
+  // /defaults starts over with one record, the old settings are in neither slot
+  config.universe = 5;
+  saveConfig();
+  writes = SPIFFS.hostWrites;
+  CHECK(SPIFFS.exists("/config.b") && defaultConfig() && SPIFFS.hostWrites == writes + 1 && !SPIFFS.exists("/config.b"), "config: defaults");
+  config.universe = 9;
+  CHECK(loadConfig() && !memcmp(&config, &defaults, sizeof(Config)), "config: defaults loaded universe %d", config.universe);
+
+  configErase();
+  SPIFFS.remove("/config.json");
+  initialConfig();
+  printf("config: ok\n");
+}
+
+static void checkAssets() {
+  typedef std::vector<std::pair<String, String> > Pairs;
+  writeFile("/page.html", "<html>plain</html>");
+  writeFile("/page.html.gz", "gzip page");
+  writeFile("/only.js.gz", "gzip only");
+  writeFile("/plain.txt", "not packed");
+  writeFile("/assets.txt", "/page.html 0000abcd 1\n/only.js 00001234 1\n");
+  loadAssets();
+  server.onNotFound(handleNotFound);
+  const HostResponse &r = server.hostResponse;
+
+  Pairs gzip(1, std::make_pair(String("Accept-Encoding"), String("gzip, deflate")));
+  server.hostRequest(HTTP_GET, "/page.html", Pairs(), gzip);
+  CHECK(r.code == 200 && r.body == "gzip page" && r.header("Content-Encoding") == "gzip" && r.contentType == "text/html",
+        "assets: gzip copy %d %s", r.code, r.body.c_str());
+  CHECK(r.header("ETag") == "\"0000abcdg\"" && r.header("Cache-Control") == "no-cache" && r.header("Vary") == "Accept-Encoding",
+        "assets: headers of the gzip copy, ETag %s", r.header("ETag").c_str());
+
+  server.hostRequest(HTTP_GET, "/page.html");
+  CHECK(r.code == 200 && r.body == "<html>plain</html>" && r.header("Content-Encoding") == "" && r.header("ETag") == "\"0000abcd\"",
+        "assets: plain file %d %s", r.code, r.body.c_str());
+
+  // the browser has the file
+  Pairs cached(1, std::make_pair(String("If-None-Match"), String("\"0000abcd\"")));
+  server.hostRequest(HTTP_GET, "/page.html", Pairs(), cached);
+  CHECK(r.code == 304 && r.body.empty() && r.header("ETag") == "\"0000abcd\"", "assets: not modified %d", r.code);
+  cached.push_back(gzip[0]);
+  server.hostRequest(HTTP_GET, "/page.html", Pairs(), cached);
+  CHECK(r.code == 200 && r.body == "gzip page", "assets: the plain ETag matched the gzip copy");
+
+  // only the gzip copy on the file system, and a file that is not packed
+  server.hostRequest(HTTP_GET, "/only.js", Pairs(), gzip);
+  CHECK(r.code == 200 && r.body == "gzip only" && r.contentType == "application/javascript", "assets: gzip only %d", r.code);
+  server.hostRequest(HTTP_GET, "/plain.txt");
+  CHECK(r.code == 200 && r.body == "not packed" && r.header("ETag") == "" && r.header("Cache-Control") == "", "assets: unpacked file");
+  server.hostRequest(HTTP_GET, "/missing.html");
+  CHECK(r.code == 404, "assets: missing file %d", r.code);
+
+  static const char *files[] = { "/page.html", "/page.html.gz", "/only.js.gz", "/plain.txt", "/assets.txt" };
+  for (unsigned i = 0; i < sizeof(files) / sizeof(files[0]); i++)
+    SPIFFS.remove(files[i]);
+  loadAssets();
+  printf("assets: ok\n");
+}
+
+/************************************************************************************/
+
+int main() {
+  hostSerialQuiet = true;
+  initialConfig();
+
+  checkFixedPoint();
+  checkHsv();
+  checkInput();
+  checkUniverses();
+  checkSync();
+  checkScheduler();
+  checkWeb();
+  checkDirty();
+  checkLut();
+  checkOutput();
+  checkHdr();
+  checkArena();
+  checkInterpolate();
+  checkModes();
+  checkStats();
+  checkStatus();
+  checkLog();
+  checkConfigStore();
+  checkAssets();
+
+  if (failures)
+    printf("%d checks failed\n", failures);
+  else
+    printf("all checks passed\n");
+  return failures ? 1 : 0;
+}
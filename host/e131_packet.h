@@ -0,0 +1,64 @@
+// Builds E1.31 packets for injection into the host UDP stub
+#ifndef _HOST_E131_PACKET_H_
+#define _HOST_E131_PACKET_H_
+
+#include <Arduino.h>
+#include <WiFiUdp.h>
+
+#define E131_PACKET_MAX 638
+
+static inline void put16(uint8_t *p, uint16_t v) { p[0] = v >> 8; p[1] = v; }
+static inline void put32(uint8_t *p, uint32_t v) { put16(p, v >> 16); put16(p + 2, v); }
+
+// data packet with the given slots, returns the packet length
+static inline size_t e131DataPacket(uint8_t *buf, uint16_t universe, uint8_t sequence, const uint8_t *slots, uint16_t count, uint16_t syncAddress = 0, uint8_t options = 0) {
+  static const char acnId[12] = "ASC-E1.17";
+  size_t len = 126 + count;
+  memset(buf, 0, 126);
+  put16(buf, 0x0010);
+  memcpy(buf + 4, acnId, 12);
+  put16(buf + 16, 0x7000 | (len - 16));
+  put32(buf + 18, 0x00000004);
+  put16(buf + 38, 0x7000 | (len - 38));
+  put32(buf + 40, 0x00000002);
+  strcpy((char *)buf + 44, "host");
+  buf[108] = 100;
+  put16(buf + 109, syncAddress);
+  buf[111] = sequence;
+  buf[112] = options;
+  put16(buf + 113, universe);
+  put16(buf + 115, 0x7000 | (len - 115));
+  buf[117] = 0x02;
+  buf[118] = 0xa1;
+  put16(buf + 121, 1);
+  put16(buf + 123, count + 1);
+  memcpy(buf + 126, slots, count);
+  return len;
+}
+
+// synchronization packet for the given sync address, returns the packet length
+static inline size_t e131SyncPacket(uint8_t *buf, uint16_t syncAddress, uint8_t sequence) {
+  static const char acnId[12] = "ASC-E1.17";
+  memset(buf, 0, 49);
+  put16(buf, 0x0010);
+  memcpy(buf + 4, acnId, 12);
+  put16(buf + 16, 0x7000 | (49 - 16));
+  put32(buf + 18, 0x00000008);
+  put16(buf + 38, 0x7000 | (49 - 38));
+  put32(buf + 40, 0x00000001);
+  buf[44] = sequence;
+  put16(buf + 45, syncAddress);
+  return 49;
+}
+
+static inline void e131SendData(uint16_t universe, uint8_t sequence, const uint8_t *slots, uint16_t count, uint16_t syncAddress = 0, uint8_t options = 0) {
+  uint8_t buf[E131_PACKET_MAX];
+  hostUdpInject(5568, buf, e131DataPacket(buf, universe, sequence, slots, count, syncAddress, options));
+}
+
+static inline void e131SendSync(uint16_t syncAddress, uint8_t sequence) {
+  uint8_t buf[49];
+  hostUdpInject(5568, buf, e131SyncPacket(buf, syncAddress, sequence));
+}
+
+#endif
@@ -0,0 +1,230 @@
+/*
+   Host stand-in for the ESP8266 Arduino core.
+
+   Only the parts that the sketch actually uses are provided. Time is
+   virtual: millis() and micros() return a clock that is advanced by
+   delay() and by the host harness, so animated modes are reproducible.
+ */
+
+#ifndef _HOST_ARDUINO_H_
+#define _HOST_ARDUINO_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <memory>
+#include <algorithm>
+
+using std::min;
+using std::max;
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define PROGMEM
+#define PGM_P               const char *
+#define PSTR(s)             (s)
+#define F(s)                (s)
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#define memcpy_P            memcpy
+#define strlen_P            strlen
+#define ICACHE_RAM_ATTR
+
+#define SCK  14
+#define MOSI 13
+
+#define LOW    0
+#define HIGH   1
+#define INPUT  0x00
+#define OUTPUT 0x01
+
+// the mode of every GPIO, INPUT after reset
+extern uint8_t hostPinMode[17];
+inline void pinMode(uint8_t pin, uint8_t mode) { if (pin < 17) hostPinMode[pin] = mode; }
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+#define HEX 16
+#define DEC 10
+
+// virtual clock, see host_arduino.cpp
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield(void);
+
+void hostSetMicros(uint64_t us);
+void hostAdvanceMicros(uint64_t us);
+extern uint32_t hostYieldCount;
+
+class String {
+  public:
+    String() {}
+    String(const char *s) : s_(s ? s : "") {}
+    String(const std::string &s) : s_(s) {}
+    String(char c) : s_(1, c) {}
+    String(int v, unsigned char base = 10) { fromLong(v, base); }
+    String(unsigned int v, unsigned char base = 10) { fromLong(v, base); }
+    String(long v, unsigned char base = 10) { fromLong(v, base); }
+    String(unsigned long v, unsigned char base = 10) { fromLong(v, base); }
+    String(float v, unsigned char decimals = 2) { fromDouble(v, decimals); }
+    String(double v, unsigned char decimals = 2) { fromDouble(v, decimals); }
+    String &operator=(const char *s) { s_ = s ? s : ""; return *this; }
+
+    const char *c_str() const { return s_.c_str(); }
+    unsigned int length() const { return s_.size(); }
+    char operator[](unsigned int i) const { return s_[i]; }
+    char charAt(unsigned int i) const { return s_[i]; }
+
+    String &operator+=(const String &rhs) { s_ += rhs.s_; return *this; }
+    String &operator+=(const char *rhs) { s_ += rhs; return *this; }
+    String &operator+=(char rhs) { s_ += rhs; return *this; }
+    String &operator+=(int rhs) { return *this += String(rhs); }
+    String &operator+=(unsigned int rhs) { return *this += String(rhs); }
+    String &operator+=(long rhs) { return *this += String(rhs); }
+    String &operator+=(unsigned long rhs) { return *this += String(rhs); }
+
+    friend String operator+(const String &a, const String &b) { return String(a.s_ + b.s_); }
+    friend String operator+(const String &a, const char *b) { return String(a.s_ + b); }
+    friend String operator+(const char *a, const String &b) { return String(a + b.s_); }
+
+    bool operator==(const String &rhs) const { return s_ == rhs.s_; }
+    bool operator==(const char *rhs) const { return s_ == rhs; }
+    bool operator!=(const String &rhs) const { return s_ != rhs.s_; }
+
+    bool startsWith(const String &p) const { return s_.compare(0, p.s_.size(), p.s_) == 0; }
+    bool endsWith(const String &p) const {
+      return s_.size() >= p.s_.size() && s_.compare(s_.size() - p.s_.size(), p.s_.size(), p.s_) == 0;
+    }
+    int indexOf(char c) const { size_t p = s_.find(c); return p == std::string::npos ? -1 : (int)p; }
+    String substring(unsigned int from) const { return String(s_.substr(from)); }
+    String substring(unsigned int from, unsigned int to) const { return String(s_.substr(from, to - from)); }
+    long toInt() const { return atol(s_.c_str()); }
+    float toFloat() const { return atof(s_.c_str()); }
+    void toCharArray(char *buf, unsigned int size) const {
+      if (!size) return;
+      strncpy(buf, s_.c_str(), size - 1);
+      buf[size - 1] = 0;
+    }
+    void reserve(unsigned int n) { s_.reserve(n); }
+
+  private:
+    void fromLong(long v, unsigned char base) {
+      char buf[34];
+      snprintf(buf, sizeof(buf), base == 16 ? "%lx" : "%ld", v);
+      s_ = buf;
+    }
+    void fromDouble(double v, unsigned char decimals) {
+      char buf[48];
+      snprintf(buf, sizeof(buf), "%.*f", decimals, v);
+      s_ = buf;
+    }
+    std::string s_;
+};
+
+class Print {
+  public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buf, size_t len) {
+      size_t n = 0;
+      while (len--) n += write(*buf++);
+      return n;
+    }
+    size_t write(const char *str) { return write((const uint8_t *)str, strlen(str)); }
+
+    size_t print(const String &s) { return write((const uint8_t *)s.c_str(), s.length()); }
+    size_t print(const char *s) { return write(s); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int v, int base = DEC) { return print(String((long)v, base)); }
+    size_t print(unsigned int v, int base = DEC) { return print(String((unsigned long)v, base)); }
+    size_t print(long v, int base = DEC) { return print(String(v, base)); }
+    size_t print(unsigned long v, int base = DEC) { return print(String(v, base)); }
+    size_t print(double v, int digits = 2) { return print(String(v, digits)); }
+    size_t println() { return write("\r\n"); }
+    template <typename T> size_t println(const T &v) { size_t n = print(v); return n + println(); }
+    template <typename T> size_t println(const T &v, int f) { size_t n = print(v, f); return n + println(); }
+    size_t printf(const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+};
+
+class Stream : public Print {
+  public:
+    virtual int available() { return 0; }
+    virtual int read() { return -1; }
+    size_t readBytesUntil(char terminator, char *buf, size_t len) {
+      size_t n = 0;
+      int c;
+      while (n < len && (c = read()) >= 0 && c != terminator) buf[n++] = c;
+      return n;
+    }
+};
+
+// bytes that Serial takes without waiting
+extern int hostSerialRoom;
+
+class HardwareSerial : public Stream {
+  public:
+    void begin(unsigned long) {}
+    void setDebugOutput(bool) {}
+    int availableForWrite() { return hostSerialRoom; }
+    void flush() {}
+    operator bool() const { return true; }
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buf, size_t len) override;
+    using Print::write;
+};
+
+extern HardwareSerial Serial;
+
+// when set, everything written to Serial is discarded (used by the benchmark)
+extern bool hostSerialQuiet;
+
+// bytes written to Serial, quiet or not
+extern uint32_t hostSerialBytes;
+
+// what goes through operator new: bytes in use, the most in use so far, and the number of allocations
+extern size_t hostHeapInUse, hostHeapPeak;
+extern uint32_t hostAllocCount;
+
+class IPAddress {
+  public:
+    IPAddress() { memset(b_, 0, 4); }
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) { b_[0] = a; b_[1] = b; b_[2] = c; b_[3] = d; }
+    uint8_t operator[](int i) const { return b_[i]; }
+    String toString() const {
+      char buf[16];
+      snprintf(buf, sizeof(buf), "%u.%u.%u.%u", b_[0], b_[1], b_[2], b_[3]);
+      return String(buf);
+    }
+  private:
+    uint8_t b_[4];
+};
+
+class EspClass {
+  public:
+    void restart() {}
+    uint32_t getFreeHeap();
+    uint32_t getFreeSketchSpace() { return 1024 * 1024; }
+    uint32_t getCycleCount() { return micros() * 80; }
+};
+
+extern EspClass ESP;
+
+class UpdaterClass {
+  public:
+    bool begin(size_t) { return true; }
+    size_t write(uint8_t *, size_t len) { return len; }
+    bool end(bool = false) { return true; }
+    bool hasError() { return false; }
+    void printError(Print &) {}
+};
+
+extern UpdaterClass Update;
+
+#endif // _HOST_ARDUINO_H_
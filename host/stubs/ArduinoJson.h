@@ -0,0 +1,130 @@
+/*
+   Host stand-in for the ArduinoJson 5 API used by the sketch: flat objects
+   with integer, float and string members, parsed from and printed to text.
+ */
+
+#ifndef _HOST_ARDUINOJSON_H_
+#define _HOST_ARDUINOJSON_H_
+
+#include <Arduino.h>
+#include <map>
+#include <vector>
+#include <deque>
+
+class JsonObject {
+  public:
+    class Value {
+      public:
+        Value(JsonObject *o, const std::string &k) : o_(o), k_(k) {}
+        Value &operator=(long v) { o_->set(k_, String(v), false); return *this; }
+        Value &operator=(int v) { return *this = (long)v; }
+        Value &operator=(unsigned int v) { return *this = (long)v; }
+        Value &operator=(unsigned long v) { return *this = (long)v; }
+        Value &operator=(double v) { o_->set(k_, String(v, 2), false); return *this; }
+        Value &operator=(float v) { return *this = (double)v; }
+        Value &operator=(const char *v) { o_->set(k_, String(v), true); return *this; }
+        Value &operator=(const String &v) { o_->set(k_, v, true); return *this; }
+        operator long() const { return o_->get(k_).toInt(); }
+        operator int() const { return o_->get(k_).toInt(); }
+        operator double() const { return o_->get(k_).toFloat(); }
+        operator const char *() const { return o_->get(k_).c_str(); }
+      private:
+        JsonObject *o_;
+        std::string k_;
+    };
+
+    JsonObject() : success_(true) {}
+
+    bool success() const { return success_; }
+    bool containsKey(const char *key) const { return index(key) >= 0; }
+    Value operator[](const char *key) { return Value(this, key); }
+
+    size_t printTo(Print &p) const {
+      std::string s = toString();
+      return p.write((const uint8_t *)s.data(), s.size());
+    }
+    size_t printTo(String &str) const {
+      std::string s = toString();
+      str += s.c_str();
+      return s.size();
+    }
+    size_t printTo(char *buf, size_t size) const {
+      std::string s = toString();
+      snprintf(buf, size, "%s", s.c_str());
+      return s.size();
+    }
+
+    bool parse(const char *json);
+    void fail() { success_ = false; }
+
+  private:
+    struct Member { std::string key; String value; bool quoted; };
+
+    int index(const std::string &key) const {
+      for (size_t i = 0; i < members_.size(); i++)
+        if (members_[i].key == key) return i;
+      return -1;
+    }
+    void set(const std::string &key, const String &value, bool quoted) {
+      int i = index(key);
+      Member m = { key, value, quoted };
+      if (i < 0) members_.push_back(m);
+      else members_[i] = m;
+    }
+    const String &get(const std::string &key) const {
+      static const String empty;
+      int i = index(key);
+      return i < 0 ? empty : members_[i].value;
+    }
+    std::string toString() const {
+      std::string s = "{";
+      for (size_t i = 0; i < members_.size(); i++) {
+        if (i) s += ",";
+        s += "\"" + members_[i].key + "\":";
+        if (members_[i].quoted) s += "\"";
+        s += members_[i].value.c_str();
+        if (members_[i].quoted) s += "\"";
+      }
+      return s + "}";
+    }
+
+    std::vector<Member> members_;
+    bool success_;
+};
+
+template <size_t CAPACITY> class StaticJsonBuffer {
+  public:
+    JsonObject &createObject() { objects_.push_back(JsonObject()); return objects_.back(); }
+    JsonObject &parseObject(const char *json) {
+      JsonObject &o = createObject();
+      if (!json || !o.parse(json)) o.fail();
+      return o;
+    }
+    JsonObject &parseObject(const String &json) { return parseObject(json.c_str()); }
+  private:
+    std::deque<JsonObject> objects_;
+};
+
+inline bool JsonObject::parse(const char *p) {
+  while (*p && *p != '{') p++;
+  if (*p++ != '{') return false;
+  for (;;) {
+    while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n' || *p == ',') p++;
+    if (*p == '}') return true;
+    if (*p++ != '"') return false;
+    const char *k = p;
+    while (*p && *p != '"') p++;
+    if (!*p) return false;
+    std::string key(k, p++);
+    while (*p == ' ' || *p == ':') p++;
+    bool quoted = (*p == '"');
+    if (quoted) p++;
+    const char *v = p;
+    while (*p && (quoted ? *p != '"' : (*p != ',' && *p != '}' && *p != ' ' && *p != '\r' && *p != '\n'))) p++;
+    if (!*p) return false;
+    set(key, String(std::string(v, p)), quoted);
+    if (quoted) p++;
+  }
+}
+
+#endif
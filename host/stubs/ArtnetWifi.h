@@ -0,0 +1,2 @@
+// Host stand-in: ArtnetWifi is included but not used by the sketch
+#include <Arduino.h>
@@ -0,0 +1,193 @@
+/*
+   Host stand-in for ESP8266WebServer.
+
+   Requests are injected with hostRequest(); the status, headers and body
+   the sketch produces are captured in hostResponse for inspection.
+   Requests queued with hostQueue() are run by handleClient() one per call,
+   advancing the clock by the time they are meant to take.
+ */
+
+#ifndef _HOST_ESP8266WEBSERVER_H_
+#define _HOST_ESP8266WEBSERVER_H_
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <FS.h>
+#include <functional>
+#include <vector>
+#include <deque>
+
+enum HTTPMethod { HTTP_ANY, HTTP_GET, HTTP_POST, HTTP_PUT, HTTP_PATCH, HTTP_DELETE, HTTP_OPTIONS };
+enum HTTPUploadStatus { UPLOAD_FILE_START, UPLOAD_FILE_WRITE, UPLOAD_FILE_END, UPLOAD_FILE_ABORTED };
+
+#define CONTENT_LENGTH_UNKNOWN ((size_t) -1)
+#define HTTP_UPLOAD_BUFLEN 2048
+
+struct HTTPUpload {
+  HTTPUploadStatus status;
+  String  filename;
+  String  name;
+  String  type;
+  size_t  totalSize;
+  size_t  currentSize;
+  uint8_t buf[HTTP_UPLOAD_BUFLEN];
+};
+
+struct HostResponse {
+  int code;
+  String contentType;
+  std::vector<std::pair<String, String> > headers;
+  std::string body;
+
+  String header(const char *name) const {
+    for (size_t i = 0; i < headers.size(); i++)
+      if (headers[i].first == name) return headers[i].second;
+    return String();
+  }
+};
+
+class WiFiClient : public Print {
+  public:
+    explicit WiFiClient(std::string *sink = NULL) : sink_(sink) {}
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t *buf, size_t len) override {
+      if (sink_) sink_->append((const char *)buf, len);
+      return len;
+    }
+    using Print::write;
+    size_t write(File &f) {
+      uint8_t buf[1460];
+      size_t n, total = 0;
+      while ((n = f.read(buf, sizeof(buf))) > 0)
+        total += write(buf, n);
+      return total;
+    }
+    bool connected() { return true; }
+    void stop() {}
+  private:
+    std::string *sink_;
+};
+
+class ESP8266WebServer {
+  public:
+    typedef std::function<void(void)> THandlerFunction;
+
+    explicit ESP8266WebServer(int port = 80) : client_(&hostResponse.body) { (void)port; }
+
+    void begin() {}
+    void handleClient();
+
+    void on(const String &uri, THandlerFunction fn) { on(uri, HTTP_ANY, fn); }
+    void on(const String &uri, HTTPMethod method, THandlerFunction fn) { on(uri, method, fn, THandlerFunction()); }
+    void on(const String &uri, HTTPMethod method, THandlerFunction fn, THandlerFunction ufn) {
+      Route r = { uri, method, fn, ufn };
+      routes_.push_back(r);
+    }
+    void onNotFound(THandlerFunction fn) { notFound_ = fn; }
+
+    void collectHeaders(const char *headerKeys[], size_t count) {
+      for (size_t i = 0; i < count; i++) collect_.push_back(headerKeys[i]);
+    }
+
+    String uri() { return uri_; }
+    HTTPMethod method() { return method_; }
+    HTTPUpload &upload() { return upload_; }
+    WiFiClient &client() { return client_; }
+
+    String arg(const String &name) {
+      for (size_t i = 0; i < args_.size(); i++)
+        if (args_[i].first == name) return args_[i].second;
+      return String();
+    }
+    String arg(int i) { return args_[i].second; }
+    String argName(int i) { return args_[i].first; }
+    int args() { return args_.size(); }
+    bool hasArg(const String &name) {
+      for (size_t i = 0; i < args_.size(); i++)
+        if (args_[i].first == name) return true;
+      return false;
+    }
+    String header(const String &name) {
+      for (size_t i = 0; i < reqHeaders_.size(); i++)
+        if (reqHeaders_[i].first == name) return reqHeaders_[i].second;
+      return String();
+    }
+    bool hasHeader(const String &name) {
+      for (size_t i = 0; i < reqHeaders_.size(); i++)
+        if (reqHeaders_[i].first == name) return true;
+      return false;
+    }
+
+    void setContentLength(size_t len) { contentLength_ = len; }
+    void sendHeader(const String &name, const String &value, bool first = false) {
+      std::pair<String, String> h(name, value);
+      if (first) hostResponse.headers.insert(hostResponse.headers.begin(), h);
+      else hostResponse.headers.push_back(h);
+    }
+    void send(int code, const char *contentType = NULL, const String &content = String()) {
+      hostResponse.code = code;
+      hostResponse.contentType = contentType ? contentType : "";
+      hostResponse.body.append(content.c_str(), content.length());
+    }
+    void send(int code, const String &contentType, const String &content) { send(code, contentType.c_str(), content); }
+    void send_P(int code, PGM_P contentType, PGM_P content, size_t len) {
+      hostResponse.code = code;
+      hostResponse.contentType = contentType;
+      hostResponse.body.append(content, len);
+    }
+    void sendContent(const String &content) { hostResponse.body.append(content.c_str(), content.length()); }
+    void sendContent_P(PGM_P content, size_t len) { hostResponse.body.append(content, len); }
+
+    template <typename T> size_t streamFile(T &file, const String &contentType) {
+      String name(file.name());
+      if (name.endsWith(".gz") && !(contentType == "application/x-gzip"))
+        sendHeader("Content-Encoding", "gzip");
+      setContentLength(file.size());
+      send(200, contentType, String());
+      return client_.write(file);
+    }
+
+    // host only: run the handler for one request and capture the response
+    void hostRequest(HTTPMethod method, const char *uri,
+                     const std::vector<std::pair<String, String> > &args = std::vector<std::pair<String, String> >(),
+                     const std::vector<std::pair<String, String> > &headers = std::vector<std::pair<String, String> >());
+    HostResponse hostResponse;
+    // host only: forget the last response but keep its memory, so that capturing the next one does not allocate
+    void hostReset() {
+      hostResponse.code = 0;
+      hostResponse.contentType = "";
+      hostResponse.headers.clear();
+      hostResponse.body.clear();
+    }
+    void hostQueue(HTTPMethod method, const char *uri, uint32_t us) {
+      Queued q = { method, uri, us };
+      queued_.push_back(q);
+    }
+    size_t hostQueued() const { return queued_.size(); }
+
+  private:
+    struct Queued {
+      HTTPMethod method;
+      String uri;
+      uint32_t us;
+    };
+    std::deque<Queued> queued_;
+    struct Route {
+      String uri;
+      HTTPMethod method;
+      THandlerFunction fn;
+      THandlerFunction ufn;
+    };
+    std::vector<Route> routes_;
+    THandlerFunction notFound_;
+    std::vector<String> collect_;
+    std::vector<std::pair<String, String> > args_;
+    std::vector<std::pair<String, String> > reqHeaders_;
+    String uri_;
+    HTTPMethod method_ = HTTP_GET;
+    HTTPUpload upload_;
+    WiFiClient client_;
+    size_t contentLength_ = CONTENT_LENGTH_UNKNOWN;
+};
+
+#endif
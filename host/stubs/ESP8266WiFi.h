@@ -0,0 +1,31 @@
+// Host stand-in for the ESP8266 WiFi station interface
+#ifndef _HOST_ESP8266WIFI_H_
+#define _HOST_ESP8266WIFI_H_
+
+#include <Arduino.h>
+
+typedef enum {
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_CONNECTED = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_DISCONNECTED = 6
+} wl_status_t;
+
+typedef enum { WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3 } WiFiMode_t;
+
+class ESP8266WiFiClass {
+  public:
+    wl_status_t begin(const char *, const char * = NULL) { return status_; }
+    bool mode(WiFiMode_t) { return true; }
+    wl_status_t status() { return status_; }
+    IPAddress localIP() { return IPAddress(127, 0, 0, 1); }
+    int32_t RSSI() { return -50; }
+    void hostSetStatus(wl_status_t s) { status_ = s; }
+  private:
+    wl_status_t status_ = WL_CONNECTED;
+};
+
+extern ESP8266WiFiClass WiFi;
+
+#endif
@@ -0,0 +1,16 @@
+// Host stand-in for the ESP8266 mDNS responder
+#ifndef _HOST_ESP8266MDNS_H_
+#define _HOST_ESP8266MDNS_H_
+
+#include <Arduino.h>
+
+class MDNSResponder {
+  public:
+    bool begin(const char *) { return true; }
+    void addService(const char *, const char *, uint16_t) {}
+    void update() {}
+};
+
+extern MDNSResponder MDNS;
+
+#endif
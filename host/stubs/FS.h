@@ -0,0 +1,98 @@
+/*
+   Host stand-in for the SPIFFS file system.
+
+   Files live in memory. SPIFFS.begin() seeds them from the directory given
+   to hostMountData() (the sketch's data/ folder), writes never reach disk.
+ */
+
+#ifndef _HOST_FS_H_
+#define _HOST_FS_H_
+
+#include <Arduino.h>
+#include <map>
+#include <vector>
+
+typedef std::shared_ptr<std::vector<uint8_t> > HostFileData;
+
+class File : public Stream {
+  public:
+    File() : pos_(0), write_(false) {}
+    File(const String &name, HostFileData d, bool w) : name_(name), data_(d), pos_(0), write_(w) {}
+
+    operator bool() const { return (bool)data_; }
+    size_t size() const { return data_ ? data_->size() : 0; }
+    size_t position() const { return pos_; }
+    bool seek(size_t pos) { if (!data_ || pos > data_->size()) return false; pos_ = pos; return true; }
+    const char *name() const { return name_.c_str(); }
+    void close() { data_.reset(); }
+
+    int available() override { return data_ ? (int)(data_->size() - pos_) : 0; }
+    int read() override { return available() ? (*data_)[pos_++] : -1; }
+    size_t read(uint8_t *buf, size_t len) {
+      size_t n = available();
+      if (len < n) n = len;
+      if (n) memcpy(buf, &(*data_)[pos_], n);
+      pos_ += n;
+      return n;
+    }
+    size_t readBytes(char *buf, size_t len) { return read((uint8_t *)buf, len); }
+    String readString() {
+      std::string s;
+      if (data_) s.assign((const char *)&(*data_)[pos_], data_->size() - pos_);
+      pos_ = size();
+      return String(s);
+    }
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t *buf, size_t len) override {
+      if (!data_ || !write_) return 0;
+      if (pos_ + len > data_->size()) data_->resize(pos_ + len);
+      memcpy(&(*data_)[pos_], buf, len);
+      pos_ += len;
+      return len;
+    }
+    using Print::write;
+
+  private:
+    String name_;
+    HostFileData data_;
+    size_t pos_;
+    bool write_;
+};
+
+class Dir {
+  public:
+    Dir() {}
+    explicit Dir(const std::vector<std::pair<String, size_t> > &e) : entries_(e), index_(-1) {}
+    bool next() { return ++index_ < (int)entries_.size(); }
+    String fileName() const { return entries_[index_].first; }
+    size_t fileSize() const { return entries_[index_].second; }
+  private:
+    std::vector<std::pair<String, size_t> > entries_;
+    int index_ = -1;
+};
+
+class FS {
+  public:
+    bool begin();
+    void end() {}
+    File open(const String &path, const char *mode);
+    File open(const char *path, const char *mode) { return open(String(path), mode); }
+    bool exists(const String &path) { return files_.count(path.c_str()) > 0; }
+    bool exists(const char *path) { return files_.count(path) > 0; }
+    bool remove(const String &path) { return files_.erase(path.c_str()) > 0; }
+    bool rename(const String &from, const String &to);
+    Dir openDir(const String &path);
+
+    void hostMountData(const char *dir) { dir_ = dir; }
+    uint32_t hostWrites = 0;   // number of files opened for writing
+
+  private:
+    std::string dir_;
+    std::map<std::string, HostFileData> files_;
+    bool mounted_ = false;
+};
+
+extern FS SPIFFS;
+
+#endif
@@ -0,0 +1,31 @@
+// Host stand-in for the ESP8266 hardware SPI master
+#ifndef _HOST_SPI_H_
+#define _HOST_SPI_H_
+
+#include <Arduino.h>
+
+#define SPI_MODE0 0x00
+#define MSBFIRST  1
+
+class SPIClass {
+  public:
+    void begin() {}
+    void end() {}
+    void setFrequency(uint32_t freq) { frequency = freq; }
+    void setBitOrder(uint8_t) {}
+    void setDataMode(uint8_t) {}
+    uint8_t transfer(uint8_t data) { sink ^= data; bytes++; return 0; }
+    void writeBytes(const uint8_t *data, uint32_t size) {
+      bytes += size;
+      while (size--)
+        sink ^= *data++;
+    }
+
+    uint32_t frequency = 8000000;
+    volatile uint8_t sink = 0;   // keeps the encoder loops from being optimized away
+    uint64_t bytes = 0;
+};
+
+extern SPIClass SPI;
+
+#endif
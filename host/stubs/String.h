@@ -0,0 +1,2 @@
+// Host stand-in: the Arduino String class lives in Arduino.h
+#include <Arduino.h>
@@ -0,0 +1,62 @@
+// Host stand-in for the ESP8266 UDP socket
+#ifndef _HOST_WIFIUDP_H_
+#define _HOST_WIFIUDP_H_
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <deque>
+#include <vector>
+
+struct HostDatagram {
+  uint16_t port;
+  std::vector<uint8_t> data;
+};
+
+// datagrams waiting to be received, in order of arrival
+extern std::deque<HostDatagram> hostDatagrams;
+
+static inline void hostUdpInject(uint16_t port, const uint8_t *data, size_t len) {
+  HostDatagram d;
+  d.port = port;
+  d.data.assign(data, data + len);
+  hostDatagrams.push_back(d);
+}
+
+class WiFiUDP {
+  public:
+    uint8_t begin(uint16_t port) { port_ = port; return 1; }
+    void stop() {}
+    static void stopAll() {}
+
+    // like the ESP8266 core, the rest of the previous datagram is dropped
+    int parsePacket() {
+      current_.clear();
+      pos_ = 0;
+      for (std::deque<HostDatagram>::iterator it = hostDatagrams.begin(); it != hostDatagrams.end(); ++it) {
+        if (it->port == port_) {
+          current_ = it->data;
+          hostDatagrams.erase(it);
+          return current_.size();
+        }
+      }
+      return 0;
+    }
+    int available() { return current_.size() - pos_; }
+    int read() { return available() ? current_[pos_++] : -1; }
+    int read(uint8_t *buf, size_t len) {
+      size_t n = available();
+      if (len < n) n = len;
+      if (n) memcpy(buf, &current_[pos_], n);
+      pos_ += n;
+      return n;
+    }
+    int read(char *buf, size_t len) { return read((uint8_t *)buf, len); }
+    IPAddress remoteIP() { return IPAddress(127, 0, 0, 1); }
+
+  private:
+    uint16_t port_ = 0;
+    std::vector<uint8_t> current_;
+    size_t pos_ = 0;
+};
+
+#endif
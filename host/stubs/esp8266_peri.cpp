@@ -0,0 +1,86 @@
+#include <esp8266_peri.h>
+#include <SPI.h>
+
+HostSpiCommand SPI1CMD;
+uint32_t SPI1U1 = 0;
+volatile uint32_t hostSpiFifo[16];
+
+HostGpioRegister GPOS(true);
+HostGpioRegister GPOC(false);
+uint32_t hostGpo = 0;
+
+static HostGpioWatch watches[4];
+static int watchCount = 0;
+
+uint64_t hostSpiBits = 0;
+uint64_t hostSpiDone = 0;
+static uint64_t hostSpiStart = 0;
+
+static uint64_t nowNs() {
+  return (uint64_t)micros() * 1000;
+}
+
+// the CPU time of a register access on the virtual clock, the part below 1 us is carried over
+static void spend(uint32_t ns) {
+  static uint32_t carry = 0;
+  carry += ns;
+  if (carry >= 1000) {
+    hostAdvanceMicros(carry / 1000);
+    carry %= 1000;
+  }
+}
+
+HostSpiCommand::operator uint32_t() {
+  // the checks set the clock back for a new run, the transfer is over then
+  if (nowNs() >= hostSpiDone || nowNs() < hostSpiStart)
+    return 0;
+  spend(HOST_POLL_NS);
+  return SPIBUSY;
+}
+
+HostSpiCommand &HostSpiCommand::operator|=(uint32_t value) {
+  if (!(value & SPIBUSY))
+    return *this;
+  uint32_t bits = ((SPI1U1 >> SPILMOSI) & SPIMMOSI) + 1;
+  for (uint32_t i = 0; i < bits / 8; i++) {
+    uint8_t data = hostSpiFifo[i / 4] >> (8 * (i % 4));
+    SPI.writeBytes(&data, 1);
+  }
+  hostSpiBits += bits;
+  if (nowNs() < hostSpiStart)
+    hostSpiDone = 0;
+  hostSpiStart = nowNs();
+  hostSpiDone = max(hostSpiDone, nowNs()) + (uint64_t)bits * 1000000000 / SPI.frequency;
+  return *this;
+}
+
+HostGpioRegister &HostGpioRegister::operator=(uint32_t mask) {
+  uint32_t before = hostGpo;
+  hostGpo = (set ? hostGpo | mask : hostGpo & ~mask);
+  for (int i = 0; i < watchCount; i++) {
+    HostGpioWatch *w = &watches[i];
+    if ((before >> w->clock & 1) || !(hostGpo >> w->clock & 1))
+      continue;
+    w->value = (w->value << 1) | (hostGpo >> w->data & 1);
+    if (++w->bits == 8) {
+      w->bytes++;
+      w->sink ^= w->value;
+      w->bits = 0;
+    }
+  }
+  spend(HOST_GPIO_NS);
+  return *this;
+}
+
+HostGpioWatch *hostGpioWatch(uint8_t clock, uint8_t data) {
+  for (int i = 0; i < watchCount; i++)
+    if (watches[i].clock == clock && watches[i].data == data)
+      return &watches[i];
+  if (watchCount == 4)
+    return NULL;
+  HostGpioWatch *w = &watches[watchCount++];
+  memset(w, 0, sizeof(*w));
+  w->clock = clock;
+  w->data = data;
+  return w;
+}
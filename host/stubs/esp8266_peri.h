@@ -0,0 +1,69 @@
+/*
+   Host stand-in for the registers of the ESP8266 that the output driver
+   programs directly.
+
+   HSPI: setting SPIBUSY in SPI1CMD clocks out the bits given by SPI1U1 from
+   the SPI1W FIFO words into the SPI stand-in, and the command stays busy
+   for the time those bits take on the wire at SPI.frequency, on the virtual
+   clock. Reading the busy bit while it is set takes HOST_POLL_NS.
+
+   GPIO: writes to GPOS and GPOC set and clear the outputs and take
+   HOST_GPIO_NS each, about what a register write costs on the device. The
+   checks attach a decoder to a clock and data pin with hostGpioWatch(),
+   which shifts in the data pin on every rising edge of the clock pin.
+ */
+
+#ifndef _HOST_ESP8266_PERI_H_
+#define _HOST_ESP8266_PERI_H_
+
+#include <Arduino.h>
+
+#define SPIBUSY  (1 << 18)
+#define SPILMOSI 17
+#define SPIMMOSI 0x1FF
+#define SPILMISO 8
+#define SPIMMISO 0x1FF
+
+#define HOST_POLL_NS 100
+#define HOST_GPIO_NS 60
+
+class HostSpiCommand {
+  public:
+    operator uint32_t();
+    HostSpiCommand &operator|=(uint32_t value);
+};
+
+extern HostSpiCommand SPI1CMD;
+extern uint32_t SPI1U1;
+extern volatile uint32_t hostSpiFifo[16];
+
+#define SPI1W(p) hostSpiFifo[(p) & 0xF]
+#define SPI1W0   SPI1W(0)
+
+class HostGpioRegister {
+  public:
+    HostGpioRegister(bool set) : set(set) {}
+    HostGpioRegister &operator=(uint32_t mask);
+  private:
+    bool set;
+};
+
+extern HostGpioRegister GPOS;
+extern HostGpioRegister GPOC;
+extern uint32_t hostGpo;   // host only: the state of the outputs
+
+struct HostGpioWatch {
+  uint8_t clock, data;
+  uint8_t bits, value;
+  uint64_t bytes;
+  uint8_t sink;            // all bytes XORed
+};
+
+// host only: decode the bytes clocked out on a pin pair, up to 4 of them
+HostGpioWatch *hostGpioWatch(uint8_t clock, uint8_t data);
+
+// host only: bits clocked out with SPI1CMD, and the ns on the virtual clock until the last one is out
+extern uint64_t hostSpiBits;
+extern uint64_t hostSpiDone;
+
+#endif
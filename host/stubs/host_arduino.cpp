@@ -0,0 +1,198 @@
+/*
+   Host runtime behind the stand-in headers: virtual clock, Serial, the
+   in-memory SPIFFS, request dispatch for the web server and a heap
+   counter so that allocations made by the sketch can be measured.
+ */
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <ESP8266WebServer.h>
+#include <WiFiUdp.h>
+#include <ESP8266mDNS.h>
+#include <SPI.h>
+#include <FS.h>
+#include <dirent.h>
+#include <stdarg.h>
+#include <new>
+
+HardwareSerial Serial;
+EspClass ESP;
+UpdaterClass Update;
+MDNSResponder MDNS;
+ESP8266WiFiClass WiFi;
+SPIClass SPI;
+FS SPIFFS;
+
+std::deque<HostDatagram> hostDatagrams;
+
+bool hostSerialQuiet = false;
+uint32_t hostSerialBytes = 0;
+int hostSerialRoom = 128;   // the TX FIFO of the UART
+uint32_t hostYieldCount = 0;
+uint8_t hostPinMode[17] = { INPUT };
+
+/***************************************************************************/
+
+static uint64_t hostMicros = 0;
+
+unsigned long millis(void) { return (unsigned long)(hostMicros / 1000); }
+unsigned long micros(void) { return (unsigned long)hostMicros; }
+void delay(unsigned long ms) { hostMicros += (uint64_t)ms * 1000; }
+void delayMicroseconds(unsigned int us) { hostMicros += us; }
+void yield(void) { hostYieldCount++; }
+void hostSetMicros(uint64_t us) { hostMicros = us; }
+void hostAdvanceMicros(uint64_t us) { hostMicros += us; }
+
+/***************************************************************************/
+
+// the heap counters cover everything that goes through operator new
+
+#define HOST_HEAP_SIZE 40960
+
+size_t hostHeapInUse = 0, hostHeapPeak = 0;
+uint32_t hostAllocCount = 0;
+
+// the block that operator delete gives back starts before the pointer of operator new, out of line
+// so that the compiler does not take it for the pointer that new returned
+static void __attribute__((noinline)) hostFree(size_t *p) {
+  free(p);
+}
+
+void *operator new(size_t size) {
+  size_t *p = (size_t *)malloc(size + sizeof(max_align_t));
+  if (!p) throw std::bad_alloc();
+  *p = size;
+  hostHeapInUse += size;
+  hostAllocCount++;
+  if (hostHeapInUse > hostHeapPeak) hostHeapPeak = hostHeapInUse;
+  return (char *)p + sizeof(max_align_t);
+}
+
+void operator delete(void *ptr) noexcept {
+  if (!ptr) return;
+  size_t *p = (size_t *)((char *)ptr - sizeof(max_align_t));
+  hostHeapInUse -= *p;
+  hostFree(p);
+}
+
+void *operator new[](size_t size) { return operator new(size); }
+void operator delete[](void *ptr) noexcept { operator delete(ptr); }
+void operator delete(void *ptr, size_t) noexcept { operator delete(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { operator delete(ptr); }
+
+uint32_t EspClass::getFreeHeap() {
+  return hostHeapInUse < HOST_HEAP_SIZE ? HOST_HEAP_SIZE - hostHeapInUse : 0;
+}
+
+/***************************************************************************/
+
+size_t HardwareSerial::write(uint8_t c) { return write(&c, 1); }
+
+size_t HardwareSerial::write(const uint8_t *buf, size_t len) {
+  hostSerialBytes += len;
+  if (!hostSerialQuiet)
+    fwrite(buf, 1, len, stdout);
+  return len;
+}
+
+size_t Print::printf(const char *fmt, ...) {
+  char buf[256];
+  va_list ap;
+  va_start(ap, fmt);
+  int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+  va_end(ap);
+  if (n < 0) return 0;
+  return write((const uint8_t *)buf, n < (int)sizeof(buf) ? n : sizeof(buf) - 1);
+}
+
+/***************************************************************************/
+
+bool FS::begin() {
+  if (mounted_)
+    return true;
+  mounted_ = true;
+  if (dir_.empty())
+    return true;
+  DIR *d = opendir(dir_.c_str());
+  if (!d)
+    return true;
+  struct dirent *e;
+  while ((e = readdir(d))) {
+    if (e->d_name[0] == '.')
+      continue;
+    std::string path = dir_ + "/" + e->d_name;
+    FILE *f = fopen(path.c_str(), "rb");
+    if (!f)
+      continue;
+    HostFileData data(new std::vector<uint8_t>());
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+      data->insert(data->end(), buf, buf + n);
+    fclose(f);
+    files_[std::string("/") + e->d_name] = data;
+  }
+  closedir(d);
+  return true;
+}
+
+File FS::open(const String &path, const char *mode) {
+  std::string p(path.c_str());
+  if (mode[0] == 'w') {
+    HostFileData data(new std::vector<uint8_t>());
+    files_[p] = data;
+    hostWrites++;
+    return File(path, data, true);
+  }
+  std::map<std::string, HostFileData>::iterator it = files_.find(p);
+  if (it == files_.end())
+    return File();
+  return File(path, it->second, mode[0] == 'a');
+}
+
+bool FS::rename(const String &from, const String &to) {
+  std::map<std::string, HostFileData>::iterator it = files_.find(from.c_str());
+  if (it == files_.end())
+    return false;
+  files_[to.c_str()] = it->second;
+  files_.erase(it);
+  return true;
+}
+
+Dir FS::openDir(const String &path) {
+  std::vector<std::pair<String, size_t> > entries;
+  for (std::map<std::string, HostFileData>::iterator it = files_.begin(); it != files_.end(); ++it)
+    if (it->first.compare(0, path.length(), path.c_str()) == 0)
+      entries.push_back(std::make_pair(String(it->first), it->second->size()));
+  return Dir(entries);
+}
+
+/***************************************************************************/
+
+void ESP8266WebServer::handleClient() {
+  if (queued_.empty())
+    return;
+  Queued q = queued_.front();
+  queued_.pop_front();
+  hostAdvanceMicros(q.us);
+  hostRequest(q.method, q.uri.c_str());
+}
+
+void ESP8266WebServer::hostRequest(HTTPMethod method, const char *uri,
+                                   const std::vector<std::pair<String, String> > &args,
+                                   const std::vector<std::pair<String, String> > &headers) {
+  hostReset();
+  contentLength_ = CONTENT_LENGTH_UNKNOWN;
+  method_ = method;
+  uri_ = uri;
+  args_ = args;
+  reqHeaders_ = headers;
+  for (size_t i = 0; i < routes_.size(); i++) {
+    if (routes_[i].uri == uri && (routes_[i].method == HTTP_ANY || routes_[i].method == method)) {
+      routes_[i].fn();
+      return;
+    }
+  }
+  if (notFound_)
+    notFound_();
+}
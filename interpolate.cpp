@@ -0,0 +1,60 @@
+#include "interpolate.h"
+#include "setup_ota.h"
+#include "mode_registry.h"
+
+extern Config config;
+
+static uint8_t blendSlots[INTERPOLATE_SLOTS];
+static DmxFrame blend = { 0, 0, 0, 0, blendSlots };
+
+// blend weight 0-256 of the current frame at the given time, the ramp is computed once per tick
+static uint16_t weight(const DmxFrame *prev, const DmxFrame *cur, uint32_t ms) {
+  uint32_t interval = cur->timestamp - prev->timestamp;
+  uint32_t elapsed = ms - cur->timestamp;
+  if (interval == 0 || interval > INTERPOLATE_MAX_INTERVAL || elapsed >= interval)
+    return 256;
+
+  uint32_t t = (elapsed << 16) / interval;   // 0-1 as 16 bit fraction
+  if (config.interpolate == INTERPOLATE_SMOOTH)
+    t = ((uint64_t)t * t >> 16) * (3 * 65536 - 2 * t) >> 16;
+  return t >> 8;
+}
+
+const DmxFrame *interpolateFrame(uint32_t channels, bool *fading) {
+  const DmxFrame *cur = inputFrame();
+  const DmxFrame *prev = inputPrevious();
+  uint16_t w = weight(prev, cur, millis());
+
+  // the channels do not fit the buffer, the current frame is shown as it is
+  uint16_t length = (channels < cur->length ? channels : cur->length);
+  *fading = (w < 256 && length <= INTERPOLATE_SLOTS);
+  if (!*fading || config.interpolate == INTERPOLATE_OFF)
+    return cur;
+
+  uint16_t n = (length < prev->length ? length : prev->length);
+  const uint8_t *a = prev->data, *b = cur->data;
+  uint16_t i = 0;
+  // the 16-bit colors of the HDR modes are blended as one value, not byte by byte
+  if (modeHdr(config.mode)) {
+    uint16_t start = constrain(config.offset, 0, (int)n);
+    for (; i < start; i++)
+      blend.data[i] = a[i] + (((int)b[i] - a[i]) * w >> 8);
+    for (; i + 1 < n; i += 2) {
+      int x = (a[i] << 8) | a[i + 1], y = (b[i] << 8) | b[i + 1];
+      int v = x + ((y - x) * w >> 8);
+      blend.data[i] = v >> 8;
+      blend.data[i + 1] = v;
+    }
+  }
+  for (; i < n; i++)
+    blend.data[i] = a[i] + (((int)b[i] - a[i]) * w >> 8);
+  // channels that were not in the previous frame are taken as they are
+  if (n < length)
+    memcpy(blend.data + n, b + n, length - n);
+
+  blend.universe = cur->universe;
+  blend.length = length;
+  blend.sequence = cur->sequence;
+  blend.timestamp = cur->timestamp;
+  return &blend;
+}
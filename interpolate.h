@@ -0,0 +1,36 @@
+#ifndef _INTERPOLATE_H_
+#define _INTERPOLATE_H_
+
+#include <Arduino.h>
+#include "e131_input.h"
+
+/*
+  Temporal interpolation between the previous and the current DMX frame, so
+  that fades look smooth at the render tick while the console sends at
+  25-44 Hz. The output reaches the current frame one frame interval after
+  it arrived, i.e. interpolation adds that much latency.
+
+  config.interpolate selects the blend, the weight runs from 0 to 1 over
+  the interval between the arrival of the two frames. Frames that are more
+  than INTERPOLATE_MAX_INTERVAL apart are not blended.
+
+  Only the channels that the mode reads are blended, into a buffer of
+  INTERPOLATE_SLOTS: the parameters of the animated modes, or the pixels
+  of modes 0 and 13 up to about 340 RGB pixels. A longer strip in those
+  modes is shown as the frames come, without interpolation.
+  In the HDR modes the channels from config.offset on are blended in pairs,
+  high byte first, so that a fine fade does not dip at the coarse steps.
+*/
+
+#define INTERPOLATE_OFF     0
+#define INTERPOLATE_LINEAR  1
+#define INTERPOLATE_SMOOTH  2   // smoothstep, 3t^2 - 2t^3
+
+#define INTERPOLATE_MAX_INTERVAL 250   // ms
+#define INTERPOLATE_SLOTS        1024
+
+// the frame to render now, fading is set as long as the output has not reached the current frame,
+// a blended frame is cut to the first channels, config.offset and the footprint of the mode
+const DmxFrame *interpolateFrame(uint32_t channels, bool *fading);
+
+#endif
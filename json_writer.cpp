@@ -0,0 +1,106 @@
+#include <stdarg.h>
+
+#include "json_writer.h"
+
+JsonWriter::JsonWriter(char *buf, size_t size) : buf(buf), size(size), len(0), first(true), full(size == 0) {
+  if (size)
+    buf[0] = 0;
+}
+
+// an overflow is kept, the document that was sent is already cut off
+void JsonWriter::rewind(void) {
+  len = 0;
+  if (size)
+    buf[0] = 0;
+}
+
+// append to the buffer, or leave it at the last complete piece if it does not fit
+void JsonWriter::print(const char *fmt, ...) {
+  if (full)
+    return;
+  va_list ap;
+  va_start(ap, fmt);
+  int n = vsnprintf(buf + len, size - len, fmt, ap);
+  va_end(ap);
+  if (n < 0 || (size_t)n >= size - len) {
+    buf[len] = 0;
+    full = true;
+    return;
+  }
+  len += n;
+}
+
+void JsonWriter::member(const char *key) {
+  if (!first)
+    print(",");
+  first = false;
+  if (key)
+    print("\"%s\":", key);
+}
+
+void JsonWriter::beginObject(const char *key) {
+  member(key);
+  print("{");
+  first = true;
+}
+
+void JsonWriter::endObject(void) {
+  print("}");
+  first = false;
+}
+
+void JsonWriter::beginArray(const char *key) {
+  member(key);
+  print("[");
+  first = true;
+}
+
+void JsonWriter::endArray(void) {
+  print("]");
+  first = false;
+}
+
+void JsonWriter::add(const char *key, int value) {
+  member(key);
+  print("%d", value);
+}
+
+void JsonWriter::add(const char *key, unsigned int value) {
+  member(key);
+  print("%u", value);
+}
+
+void JsonWriter::add(const char *key, long value) {
+  member(key);
+  print("%ld", value);
+}
+
+void JsonWriter::add(const char *key, unsigned long value) {
+  member(key);
+  print("%lu", value);
+}
+
+void JsonWriter::add(const char *key, double value, uint8_t decimals) {
+  member(key);
+  print("%.*f", decimals, value);
+}
+
+void JsonWriter::add(const char *key, bool value) {
+  member(key);
+  print(value ? "true" : "false");
+}
+
+// quotes, backslashes and control characters are escaped
+void JsonWriter::add(const char *key, const char *value) {
+  member(key);
+  print("\"");
+  for (const char *c = value; *c && !full; c++) {
+    if (*c == '"' || *c == '\\')
+      print("\\%c", *c);
+    else if ((uint8_t)*c < 0x20)
+      print("\\u%04x", *c);
+    else
+      print("%c", *c);
+  }
+  print("\"");
+}
@@ -0,0 +1,61 @@
+#ifndef _JSON_WRITER_H_
+#define _JSON_WRITER_H_
+
+#include <Arduino.h>
+
+/*
+  JSON printed straight into a buffer of the caller, for the responses that
+  a monitor polls every second. Nothing is allocated: every member is
+  printed as it is added, so the buffer is the only memory, and it is
+  usually on the stack of the handler. A document that does not fit is cut
+  off where it ran out of space and overflow() is set, the caller sends an
+  error instead.
+
+    char buf[256];
+    JsonWriter json(buf, sizeof(buf));
+    json.beginObject();
+    json.add("pixels", config.pixels);
+    json.endObject();
+    server.send_P(200, "application/json", json.c_str(), json.length());
+
+  A document that is longer than the buffer is sent in pieces: after the
+  contents were sent with sendContent_P(), rewind() starts over at the front
+  of the buffer and the next member still gets its comma.
+*/
+
+class JsonWriter {
+  public:
+    JsonWriter(char *buf, size_t size);
+
+    // the key is only used inside an object
+    void beginObject(const char *key = NULL);
+    void endObject(void);
+    void beginArray(const char *key = NULL);
+    void endArray(void);
+
+    void add(const char *key, int value);
+    void add(const char *key, unsigned int value);
+    void add(const char *key, long value);
+    void add(const char *key, unsigned long value);
+    void add(const char *key, double value, uint8_t decimals = 2);
+    void add(const char *key, bool value);
+    void add(const char *key, const char *value);
+
+    const char *c_str(void) const { return buf; }
+    size_t length(void) const { return len; }
+    bool overflow(void) const { return full; }
+
+    // empty the buffer after its contents were sent, inside the same document
+    void rewind(void);
+
+  private:
+    void member(const char *key);
+    void print(const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+    char *buf;
+    size_t size, len;
+    bool first;   // no comma before the next member
+    bool full;
+};
+
+#endif
@@ -0,0 +1,111 @@
+#include <stdarg.h>
+#include <ESP8266WebServer.h>
+
+#include "log.h"
+
+#if LOG_LEVEL > LOG_OFF
+
+extern ESP8266WebServer server;
+
+static char ring[LOG_RING];
+static uint32_t head = 0;     // bytes ever written, the next one goes to ring[head % LOG_RING]
+static uint32_t serial = 0;   // bytes ever written to the serial port
+static uint32_t oldest = 0;   // the first byte of the oldest complete line in the ring
+
+uint32_t logDropped = 0;
+
+static const char levels[] = "-EWID";
+
+static const char *categoryName(uint8_t category) {
+  switch (category) {
+    case LOG_SETUP:  return "setup";
+    case LOG_WEB:    return "web";
+    case LOG_CONFIG: return "config";
+    case LOG_WIFI:   return "wifi";
+    case LOG_OUTPUT: return "output";
+  }
+  return "?";
+}
+
+// the oldest line that was overwritten is gone, the next one starts after its newline
+static void forget(uint32_t until) {
+  while (oldest < until) {
+    while (oldest < head && ring[oldest % LOG_RING] != '\n')
+      oldest++;
+    oldest++;
+  }
+  if (serial < oldest) {
+    // count the lines between the serial port and the oldest line that are lost
+    for (uint32_t i = serial; i < oldest; i++)
+      if (ring[i % LOG_RING] == '\n')
+        logDropped++;
+    serial = oldest;
+  }
+}
+
+void logPrintf(uint8_t level, uint8_t category, const char *fmt, ...) {
+  char line[LOG_LINE];
+  uint32_t now = millis();
+  int n = snprintf(line, sizeof(line), "%lu.%03lu %c %s: ", (unsigned long)(now / 1000), (unsigned long)(now % 1000),
+                   levels[level < sizeof(levels) - 1 ? level : 0], categoryName(category));
+  va_list ap;
+  va_start(ap, fmt);
+  int m = vsnprintf(line + n, sizeof(line) - n, fmt, ap);
+  va_end(ap);
+  n = (m < 0 ? n : min(n + m, (int)sizeof(line) - 2));
+  line[n++] = '\n';
+
+  // the bytes that are about to be overwritten, whole lines at a time
+  if (head + n > oldest + LOG_RING) {
+    uint32_t until = head + n - LOG_RING;
+    // the newlines of the old lines are still in the ring while it is searched
+    forget(until);
+  }
+  for (int i = 0; i < n; i++)
+    ring[(head + i) % LOG_RING] = line[i];
+  head += n;
+}
+
+void logDrain(void) {
+  while (serial < head) {
+    int room = Serial.availableForWrite();
+    if (room <= 0)
+      return;
+    uint32_t start = serial % LOG_RING;
+    uint32_t n = min((uint32_t)room, min(head - serial, (uint32_t)LOG_RING - start));
+    Serial.write((const uint8_t *)ring + start, n);
+    serial += n;
+  }
+}
+
+void logFlush(void) {
+  while (serial < head) {
+    uint32_t start = serial % LOG_RING;
+    uint32_t n = min(head - serial, (uint32_t)LOG_RING - start);
+    Serial.write((const uint8_t *)ring + start, n);
+    serial += n;
+  }
+  Serial.flush();
+}
+
+void logContents(const char **first, size_t *firstLength, const char **second, size_t *secondLength) {
+  uint32_t start = oldest % LOG_RING;
+  uint32_t length = head - oldest;
+  *first = ring + start;
+  *firstLength = min(length, (uint32_t)LOG_RING - start);
+  *second = ring;
+  *secondLength = length - *firstLength;
+}
+
+void handleLog() {
+  const char *first, *second;
+  size_t firstLength, secondLength;
+  logContents(&first, &firstLength, &second, &secondLength);
+  server.setContentLength(firstLength + secondLength);
+  server.send(200, "text/plain", "");
+  server.sendContent_P(first, firstLength);
+  if (secondLength)
+    server.sendContent_P(second, secondLength);
+}
+
+#endif
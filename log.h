@@ -0,0 +1,81 @@
+#ifndef _LOG_H_
+#define _LOG_H_
+
+#include <Arduino.h>
+
+/*
+  Logging into a ring buffer in RAM instead of straight to the serial port,
+  which blocks the loop at 115200 baud as soon as its FIFO is full. A
+  message is formatted on the stack and copied into the ring, logDrain()
+  moves the ring to the serial port as far as it takes bytes without
+  blocking and is called when the loop has nothing else to do. When the
+  ring is full the oldest lines are overwritten, logDropped counts the
+  lines that never made it to the serial port. /log returns the lines that
+  are still in the ring.
+
+  Every message has a level and a category. Messages above LOG_LEVEL or
+  outside LOG_CATEGORIES are compiled out completely, including the
+  evaluation of their arguments. A release build with LOG_LEVEL set to
+  LOG_OFF has no logging at all: no ring, nothing to drain and no /log.
+*/
+
+#define LOG_OFF    0
+#define LOG_ERROR  1
+#define LOG_WARN   2
+#define LOG_INFO   3
+#define LOG_DEBUG  4
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_INFO
+#endif
+
+#define LOG_SETUP  0x01
+#define LOG_WEB    0x02
+#define LOG_CONFIG 0x04
+#define LOG_WIFI   0x08
+#define LOG_OUTPUT 0x10
+
+#ifndef LOG_CATEGORIES
+#define LOG_CATEGORIES 0xFF
+#endif
+
+#define LOG_RING   2048   // bytes
+#define LOG_LINE   120    // bytes, a longer message is cut off
+
+#define LOG(level, category, ...) do { \
+    if ((level) <= LOG_LEVEL && ((category) & LOG_CATEGORIES)) \
+      logPrintf(level, category, __VA_ARGS__); \
+  } while (0)
+
+#define LOG_E(category, ...) LOG(LOG_ERROR, category, __VA_ARGS__)
+#define LOG_W(category, ...) LOG(LOG_WARN, category, __VA_ARGS__)
+#define LOG_I(category, ...) LOG(LOG_INFO, category, __VA_ARGS__)
+#define LOG_D(category, ...) LOG(LOG_DEBUG, category, __VA_ARGS__)
+
+#if LOG_LEVEL > LOG_OFF
+
+// one line with the time, the level and the category in front, use the macros above
+void logPrintf(uint8_t level, uint8_t category, const char *fmt, ...) __attribute__((format(printf, 3, 4)));
+
+// write as much of the ring to the serial port as it takes without waiting
+void logDrain(void);
+
+// write all of the ring to the serial port, e.g. before a restart
+void logFlush(void);
+
+// the lines in the ring, oldest first, as two pieces because the ring wraps around
+void logContents(const char **first, size_t *firstLength, const char **second, size_t *secondLength);
+
+void handleLog(void);
+
+extern uint32_t logDropped;
+
+#else
+
+// the macros above never get here, these only keep the calls compiling
+static inline __attribute__((format(printf, 3, 4))) void logPrintf(uint8_t, uint8_t, const char *, ...) {}
+static inline void logFlush(void) {}
+
+#endif
+
+#endif
@@ -0,0 +1,54 @@
+#include "mode_registry.h"
+#include "setup_ota.h"
+
+extern Config config;
+extern DotStarStrip strip;
+
+uint8_t modeFormat = FORMAT_RGB;
+
+void modeSelect(void) {
+  modeFormat = (config.leds == 4 && config.white ? FORMAT_RGBW : FORMAT_RGB);
+}
+
+const ModeInfo *modeInfo(int m) {
+  return (m >= 0 && m < (int)MODE_COUNT ? &modeTable[m] : NULL);
+}
+
+bool modeAnimated(int m) {
+  const ModeInfo *info = modeInfo(m);
+  return info && info->animated;
+}
+
+bool modeHdr(int m) {
+  const ModeInfo *info = modeInfo(m);
+  return info && info->hdr;
+}
+
+uint32_t modeFootprint(int m) {
+  const ModeInfo *info = modeInfo(m);
+  if (!info)
+    return 0;
+  uint32_t channels = (modeFormat == FORMAT_RGBW ? info->rgbw : info->rgb);
+  if (info->repeat == MODE_PER_PIXEL)
+    channels *= strip.numPixels();
+  else if (info->repeat == MODE_PER_SEGMENT)
+    channels *= (config.position > 0 ? config.position : 0);
+  return channels;
+}
+
+uint8_t modePixelChannels(int m) {
+  const ModeInfo *info = modeInfo(m);
+  if (!info || info->repeat != MODE_PER_PIXEL)
+    info = &modeTable[0];
+  return (modeFormat == FORMAT_RGBW ? info->rgbw : info->rgb);
+}
+
+bool modeRender(int m, const DmxFrame *frame) {
+  const ModeInfo *info = modeInfo(m);
+  if (!info || frame->universe != config.universe)
+    return false;
+  if (config.offset < 0 || frame->length < config.offset + modeFootprint(m))
+    return false;
+  info->render[modeFormat](frame->universe, frame->length, frame->sequence, frame->data);
+  return true;
+}
@@ -0,0 +1,109 @@
+#ifndef _MODE_REGISTRY_H_
+#define _MODE_REGISTRY_H_
+
+#include <Arduino.h>
+#include "neopixel_mode.h"
+#include "e131_input.h"
+#include "pixel_format.h"
+
+/*
+  Descriptors of the modes, config.mode is the index in modeTable.
+
+  channels    the names of the DMX channels of the mode, separated by commas.
+              The channels that start with "white" are only used with RGBW
+              strips, the channel footprints for RGB and RGBW are derived from
+              this list at compile time. Channels that end in " fine" are the
+              low bytes of 16-bit values.
+  repeat      whether the channels are used once, once per pixel (modes 0 and 13) or
+              once per segment (mode 3, config.position segments)
+  animated    the mode changes over time and is rendered on every tick, the
+              other modes only when there is a new frame
+  render      the kernel of the mode for each pixel format, modeRender calls
+              the one for the format selected by modeSelect()
+*/
+
+#define MODE_ONCE         0
+#define MODE_PER_PIXEL    1
+#define MODE_PER_SEGMENT  2
+
+typedef void (*ModeFunction)(uint16_t, uint16_t, uint8_t, const uint8_t *);
+
+struct ModeInfo {
+  const char *name;
+  const char *channels;
+  uint8_t repeat;
+  bool animated;
+  ModeFunction render[FORMAT_COUNT];
+  uint8_t rgb;    // channels with RGB, per pixel or segment if repeated
+  uint8_t rgbw;   // channels with RGBW
+  bool hdr;       // 16-bit channels, transmitted by hdrShow() instead of showPixels()
+};
+
+// compile time helpers to derive the footprint from the channel names
+constexpr uint8_t countChannels(const char *s) {
+  return *s == 0 ? 1 : (*s == ',') + countChannels(s + 1);
+}
+constexpr bool startsWith(const char *s, const char *prefix) {
+  return *prefix == 0 || (*s == *prefix && startsWith(s + 1, prefix + 1));
+}
+constexpr bool contains(const char *s, const char *word) {
+  return *s != 0 && (startsWith(s, word) || contains(s + 1, word));
+}
+constexpr uint8_t countWhite(const char *s, bool first = true) {
+  return *s == 0 ? 0 : (first && startsWith(s, "white")) + countWhite(s + 1, *s == ',');
+}
+
+#define MODE(name, channels, repeat, animated, render) \
+  { name, channels, repeat, animated, { render<FormatRGB>, render<FormatRGBW> }, (uint8_t)(countChannels(channels) - countWhite(channels)), countChannels(channels), \
+    contains(channels, " fine") }
+
+constexpr ModeInfo modeTable[] = {
+  MODE("individual pixel control",  "red,green,blue,white", MODE_PER_PIXEL, false, mode0),
+  MODE("single uniform color",      "red,green,blue,white,intensity", MODE_ONCE, false, mode1),
+  MODE("two color mixing",          "red1,green1,blue1,white1,red2,green2,blue2,white2,intensity,balance", MODE_ONCE, false, mode2),
+  MODE("blinking color",            "red,green,blue,white,intensity,speed,ramp,duty", MODE_PER_SEGMENT, true, mode3),
+  MODE("blinking between two colors", "red1,green1,blue1,white1,red2,green2,blue2,white2,intensity,speed,ramp,duty", MODE_ONCE, true, mode4),
+  MODE("single color slider",       "red,green,blue,white,intensity,position,width", MODE_ONCE, false, mode5),
+  MODE("dual color slider",         "red1,green1,blue1,white1,red2,green2,blue2,white2,intensity,position,width", MODE_ONCE, false, mode6),
+  MODE("single color smooth slider", "red,green,blue,white,intensity,position,width,ramp", MODE_ONCE, false, mode7),
+  MODE("dual color smooth slider",  "red1,green1,blue1,white1,red2,green2,blue2,white2,intensity,position,width,ramp", MODE_ONCE, false, mode8),
+  MODE("spinning color wheel",      "red,green,blue,white,intensity,speed,width,ramp", MODE_ONCE, true, mode9),
+  MODE("spinning color wheel with background", "red1,green1,blue1,white1,red2,green2,blue2,white2,intensity,speed,width,ramp", MODE_ONCE, true, mode10),
+  MODE("rainbow slider",            "saturation,value,position", MODE_ONCE, false, mode11),
+  MODE("rainbow spinner",           "saturation,value,speed", MODE_ONCE, true, mode12),
+  MODE("individual pixel control, 16 bit", "red,red fine,green,green fine,blue,blue fine,white,white fine", MODE_PER_PIXEL, false, mode13),
+};
+
+#define MODE_COUNT (sizeof(modeTable) / sizeof(modeTable[0]))
+
+// the footprints that the modes used to check themselves
+static_assert(modeTable[0].rgb == 3 && modeTable[0].rgbw == 4, "mode 0 footprint");
+static_assert(modeTable[2].rgb == 8 && modeTable[2].rgbw == 10, "mode 2 footprint");
+static_assert(modeTable[3].rgb == 7 && modeTable[3].rgbw == 8, "mode 3 footprint");
+static_assert(modeTable[6].rgb == 9 && modeTable[6].rgbw == 11, "mode 6 footprint");
+static_assert(modeTable[10].rgb == 10 && modeTable[10].rgbw == 12, "mode 10 footprint");
+static_assert(modeTable[12].rgb == 3 && modeTable[12].rgbw == 3, "mode 12 footprint");
+static_assert(modeTable[13].rgb == 6 && modeTable[13].rgbw == 8 && modeTable[13].hdr && !modeTable[0].hdr, "mode 13 footprint");
+
+// FORMAT_RGB or FORMAT_RGBW, as selected from the configuration
+extern uint8_t modeFormat;
+
+// select the pixel format from config.leds and config.white, call this when the configuration changes
+void modeSelect(void);
+
+// NULL if there is no such mode
+const ModeInfo *modeInfo(int m);
+
+bool modeAnimated(int m);
+bool modeHdr(int m);
+
+// DMX channels used by the mode with the selected format and the current configuration, from config.offset on
+uint32_t modeFootprint(int m);
+
+// DMX channels per pixel of the modes with a color per pixel, for the other modes those of mode 0
+uint8_t modePixelChannels(int m);
+
+// validate the frame against the mode and render it, returns false if that was not possible
+bool modeRender(int m, const DmxFrame *frame);
+
+#endif
@@ -1,6 +1,12 @@
 #include "neopixel_mode.h"
 #include "setup_ota.h"
 #include "colorspace.h"
+#include "fixed_math.h"
+#include "pixel_ops.h"
+#include "pixel_format.h"
+#include "apa102.h"
+#include "output_driver.h"
+#include "log.h"
 
 
 //  NeoPixel
@@ -13,32 +19,10 @@
 
 extern Config config;
 // extern Adafruit_NeoPixel strip;
-extern Adafruit_DotStar strip;
+extern DotStarStrip strip;
 
 extern long tic_frame;
-float prev;
-
-int gamma_l[] = {
-  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  1,  1,  1,  1,
-  1,  1,  1,  1,  1,  1,  1,  1,  1,  2,  2,  2,  2,  2,  2,  2,
-  2,  3,  3,  3,  3,  3,  3,  3,  4,  4,  4,  4,  4,  5,  5,  5,
-  5,  6,  6,  6,  6,  7,  7,  7,  7,  8,  8,  8,  9,  9,  9, 10,
-  10, 10, 11, 11, 11, 12, 12, 13, 13, 13, 14, 14, 15, 15, 16, 16,
-  17, 17, 18, 18, 19, 19, 20, 20, 21, 21, 22, 22, 23, 24, 24, 25,
-  25, 26, 27, 27, 28, 29, 29, 30, 31, 32, 32, 33, 34, 35, 35, 36,
-  37, 38, 39, 39, 40, 41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 50,
-  51, 52, 54, 55, 56, 57, 58, 59, 60, 61, 62, 63, 64, 66, 67, 68,
-  69, 70, 72, 73, 74, 75, 77, 78, 79, 81, 82, 83, 85, 86, 87, 89,
-  90, 92, 93, 95, 96, 98, 99, 101, 102, 104, 105, 107, 109, 110, 112, 114,
-  115, 117, 119, 120, 122, 124, 126, 127, 129, 131, 133, 135, 137, 138, 140, 142,
-  144, 146, 148, 150, 152, 154, 156, 158, 160, 162, 164, 167, 169, 171, 173, 175,
-  177, 180, 182, 184, 186, 189, 191, 193, 196, 198, 200, 203, 205, 208, 210, 213,
-  215, 218, 220, 223, 225, 228, 231, 233, 236, 239, 241, 244, 247, 249, 252, 255
-};
-
-#define RGB  (config.leds==3 || (config.leds==4 && !config.white))
-#define RGBW (                  (config.leds==4 &&  config.white))
+uint32_t prev;    // previous temporal phase, see fixed_math.h
 
 /*
   mode 0: individual pixel control
@@ -50,32 +34,31 @@ int gamma_l[] = {
   etc.
 */
 
-void mode0(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data) {
-  int i = 0, r, g, b, w;
-  if (universe != config.universe)
-    return;
-  if (RGB && (length - config.offset) < 3 * strip.numPixels() + 1)
-    return;
-  if (RGBW && (length - config.offset) < 4 * strip.numPixels() + 1)
+template <class F>
+void mode0(uint16_t universe, uint16_t length, uint8_t sequence, const uint8_t * data) {
+  int i = 0, r, g, b, w = 0;
+
+  // without color mapping the channels can be copied as they are
+  if (!F::white && !config.hsv) {
+    copyPixels(0, data + config.offset, strip.numPixels());
+    showPixels();
     return;
+  }
 
-  for (int pixel = 0; pixel < strip.numPixels(); pixel++) {
+  uint8_t *p = strip.getPixels();
+  for (int pixel = 0; pixel < strip.numPixels(); pixel++, p += PIXEL_BYTES) {
     r         = data[config.offset + i++];
     g         = data[config.offset + i++];
     b         = data[config.offset + i++];
-    if (RGBW)
+    if (F::white)
       w       = data[config.offset + i++];
 
     if (config.hsv)
       map_hsv_to_rgb(&r, &g, &b);
 
-    if (RGB)
-      strip.setPixelColor(pixel, r, g, b);
-    //else if (RGBW)
-    //  strip.setPixelColor(pixel, r, g, b, w);
-    yield();
+    F::put(p, r, g, b, w);
   }
-  strip.show();
+  showPixels();
 }
 
 /*
@@ -87,23 +70,18 @@ void mode0(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data)
   channel 5 = intensity (this allows scaling a preset RGBW color with a single channel)
 */
 
-void mode1(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data) {
-  int i = 0, r, g, b, w;
+template <class F>
+void mode1(uint16_t universe, uint16_t length, uint8_t sequence, const uint8_t * data) {
+  int i = 0, r, g, b, w = 0;
   float intensity;
 
   //myDebug2("mode1 - A");
 
-  if (universe != config.universe)
-    return;
-  if (RGB && (length - config.offset) < 3 + 1)
-    return;
-  if (RGBW && (length - config.offset) < 4 + 1)
-    return;
   // myDebug2("mode1 - B");
   r         = data[config.offset + i++];
   g         = data[config.offset + i++];
   b         = data[config.offset + i++];
-  if (RGBW)
+  if (F::white)
     w       = data[config.offset + i++];
   intensity = 1. * data[config.offset + i++] / 255.;
 
@@ -118,14 +96,8 @@ void mode1(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data)
   w = intensity * w;
 
   // myDebug2("mode1 - D");
-  for (int pixel = 0; pixel < strip.numPixels(); pixel++) {
-    if (RGB)
-      strip.setPixelColor(pixel, r, g, b);
-    //else if (RGBW)
-    //  strip.setPixelColor(pixel, r, g, b, w);
-    yield();
-  }
-  strip.show();
+  F::fill(0, strip.numPixels(), r, g, b, w);
+  showPixels();
 }
 
 /*
@@ -142,24 +114,19 @@ void mode1(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data)
   channel 10 = balance (between color 1 and color2)
 */
 
-void mode2(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data) {
-  int i = 0, r, g, b, w, r2, g2, b2, w2;
+template <class F>
+void mode2(uint16_t universe, uint16_t length, uint8_t sequence, const uint8_t * data) {
+  int i = 0, r, g, b, w = 0, r2, g2, b2, w2 = 0;
   float balance, intensity;
-  if (universe != config.universe)
-    return;
-  if (RGB && (length - config.offset) < 2 * 3 + 2)
-    return;
-  if (RGBW && (length - config.offset) < 2 * 4 + 2)
-    return;
   r         = data[config.offset + i++];
   g         = data[config.offset + i++];
   b         = data[config.offset + i++];
-  if (RGBW)
+  if (F::white)
     w       = data[config.offset + i++];
   r2        = data[config.offset + i++];
   g2        = data[config.offset + i++];
   b2        = data[config.offset + i++];
-  if (RGBW)
+  if (F::white)
     w2      = data[config.offset + i++];
   intensity = 1. * data[config.offset + i++] / 255.;
   balance   = 1. * data[config.offset + i++] / 255.;
@@ -181,14 +148,8 @@ void mode2(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data)
   b = intensity * b;
   w = intensity * w;
 
-  for (int pixel = 0; pixel < strip.numPixels(); pixel++) {
-    if (RGB)
-      strip.setPixelColor(pixel, r, g, b);
-    //else if (RGBW)
-    //  strip.setPixelColor(pixel, r, g, b, w);
-    yield();
-  }
-  strip.show();
+  F::fill(0, strip.numPixels(), r, g, b, w);
+  showPixels();
 }
 
 /*
@@ -203,80 +164,70 @@ void mode2(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data)
   channel 8 = duty cycle (the time ratio between the color and black)
 */
 
-void mode3(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data) {
-  int i = 0, r, g, b, w;
-  float intensity, speed, ramp, duty, phase, balance;
-  if (universe != config.universe)
-    return;
-  if (RGB && (length - config.offset) < (3 + 4) * config.position)
-    return;
-  if (RGBW && (length - config.offset) < (4 + 4) * config.position)
-    return;
+template <class F>
+void mode3(uint16_t universe, uint16_t length, uint8_t sequence, const uint8_t * data) {
+  int i = 0, r, g, b, w = 0;
+  uint32_t speed, ramp, duty, phase;
+  q16_t intensity, balance;
 
   // the code that takes care of the blinking repeats for each of the segments
   for (int segment = 0; segment < config.position; segment++) {
     r         = data[config.offset + i++];
     g         = data[config.offset + i++];
     b         = data[config.offset + i++];
-    if (RGBW)
+    if (F::white)
       w       = data[config.offset + i++];
-    intensity = data[config.offset + i++] / 255.;
-    speed     = 1. * data[config.offset + i++] / config.speed;
-    ramp      = 1. * data[config.offset + i++] * 360. / 255.;
-    duty      = 1. * data[config.offset + i++] * 360. / 255.;
+    intensity = DMX_TO_Q16(data[config.offset + i++]);
+    speed     = data[config.offset + i++];
+    ramp      = DMX_TO_ANGLE(data[config.offset + i++]);
+    duty      = DMX_TO_ANGLE(data[config.offset + i++]);
 
     if (config.hsv)
       map_hsv_to_rgb(&r, &g, &b);
 
     // the ramp cannot be too wide
-    if (duty < 180)
-      ramp = (ramp < duty ? ramp : duty);
+    if (duty < ANGLE_180)
+      ramp = MIN(ramp, duty);
     else
-      ramp = (ramp < (360 - duty) ? ramp : (360 - duty));
+      ramp = MIN(ramp, ANGLE_360 - duty);
 
     // determine the current phase in the temporal cycle
-    phase = (speed * millis()) * 360. / 1000.;
+    phase = qphase(speed, config.speed, millis());
 
     // prevent rolling back
     // only feasible with a single segment
-    if (config.position == 1 && WRAP180(phase - prev) < 0)
+    if (config.position == 1 && AWRAP180(phase - prev) < 0)
       phase = prev;
     else
       prev = phase;
 
-    phase = WRAP180(phase);
-    phase = ABS(phase);
+    // compare in quarter degrees, the edges are at duty/2 -/+ ramp/4
+    phase = 4 * AABS(phase);
 
-    if (phase <= (duty / 2 - ramp / 4))
-      balance = 1;
-    else if (phase >= (duty / 2 + ramp / 4))
+    if (phase <= 2 * duty - ramp)
+      balance = Q16_ONE;
+    else if (phase >= 2 * duty + ramp)
       balance = 0;
-    else if (ramp > 0)
-      balance = ((duty / 2 + ramp / 4) - phase) / ( ramp / 2 );
+    else
+      balance = qramp(phase - (2 * duty - ramp), 2 * ramp, qreciprocal(2 * ramp));
 
     // scale with the intensity
-    r *= intensity;
-    g *= intensity;
-    b *= intensity;
-    w *= intensity;
+    r = QSCALE(r, intensity);
+    g = QSCALE(g, intensity);
+    b = QSCALE(b, intensity);
+    w = QSCALE(w, intensity);
 
     // scale with the balance
-    r *= balance;
-    g *= balance;
-    b *= balance;
-    w *= balance;
+    r = QSCALE(r, balance);
+    g = QSCALE(g, balance);
+    b = QSCALE(b, balance);
+    w = QSCALE(w, balance);
 
     int begpixel = MAX((segment + 0) * strip.numPixels() / config.position, 0);
     int endpixel = MIN((segment + 1) * strip.numPixels() / config.position, strip.numPixels());
-    for (int pixel = begpixel; pixel < endpixel; pixel++) {
-      if (RGB)
-        strip.setPixelColor(pixel, r, g, b);
-      //else if (RGBW)
-      //  strip.setPixelColor(pixel, r, g, b, w);
-      yield();
-    }
+    F::fill(begpixel, endpixel - begpixel, r, g, b, w);
   }
-  strip.show();
+  showPixels();
 }
 
 /*
@@ -295,29 +246,25 @@ void mode3(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data)
   channel 12 = duty cycle
 */
 
-void mode4(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data) {
-  int i = 0, r, g, b, w, r2, g2, b2, w2;
-  float intensity, speed, ramp, duty, phase, balance;
-  if (universe != config.universe)
-    return;
-  if (RGB && (length - config.offset) < 2 * 3 + 4)
-    return;
-  if (RGBW && (length - config.offset) < 2 * 4 + 4)
-    return;
+template <class F>
+void mode4(uint16_t universe, uint16_t length, uint8_t sequence, const uint8_t * data) {
+  int i = 0, r, g, b, w = 0, r2, g2, b2, w2 = 0;
+  uint32_t speed, ramp, duty, phase;
+  q16_t intensity, balance;
   r         = data[config.offset + i++];
   g         = data[config.offset + i++];
   b         = data[config.offset + i++];
-  if (RGBW)
+  if (F::white)
     w       = data[config.offset + i++];
   r2        = data[config.offset + i++];
   g2        = data[config.offset + i++];
   b2        = data[config.offset + i++];
-  if (RGBW)
+  if (F::white)
     w2      = data[config.offset + i++];
-  intensity = 1. * data[config.offset + i++] / 255.;
-  speed     = 1. * data[config.offset + i++] / config.speed;
-  ramp      = 1. * data[config.offset + i++] * 360. / 255.;
-  duty      = 1. * data[config.offset + i++] * 360. / 255.;
+  intensity = DMX_TO_Q16(data[config.offset + i++]);
+  speed     = data[config.offset + i++];
+  ramp      = DMX_TO_ANGLE(data[config.offset + i++]);
+  duty      = DMX_TO_ANGLE(data[config.offset + i++]);
 
   if (config.hsv) {
     map_hsv_to_rgb(&r, &g, &b);
@@ -325,50 +272,53 @@ void mode4(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data)
   }
 
   // the ramp cannot be too wide
-  if (duty < 180)
-    ramp = (ramp < duty ? ramp : duty);
+  if (duty < ANGLE_180)
+    ramp = MIN(ramp, duty);
   else
-    ramp = (ramp < (360 - duty) ? ramp : (360 - duty));
+    ramp = MIN(ramp, ANGLE_360 - duty);
 
   // determine the current phase in the temporal cycle
-  phase = (speed * millis()) * 360. / 1000.;
+  phase = qphase(speed, config.speed, millis());
 
   // prevent rolling back
-  if (WRAP180(phase - prev) < 0)
+  if (AWRAP180(phase - prev) < 0)
     phase = prev;
   else
     prev = phase;
 
-  phase = WRAP180(phase);
-  phase = ABS(phase);
+  // compare in quarter degrees, the edges are at duty/2 -/+ ramp/4
+  phase = 4 * AABS(phase);
 
-  if (phase <= (duty / 2 - ramp / 4))
-    balance = 1;
-  else if (phase >= (duty / 2 + ramp / 4))
+  if (phase <= 2 * duty - ramp)
+    balance = Q16_ONE;
+  else if (phase >= 2 * duty + ramp)
     balance = 0;
-  else if (ramp > 0)
-    balance = ((duty / 2 + ramp / 4) - phase) / ( ramp / 2 );
+  else
+    balance = qramp(phase - (2 * duty - ramp), 2 * ramp, qreciprocal(2 * ramp));
 
-  // apply the balance between the two colors
-  r = BALANCE(balance, r, r2);
-  g = BALANCE(balance, g, g2);
-  b = BALANCE(balance, b, b2);
-  w = BALANCE(balance, w, w2);
+  // apply the balance between the two colors and scale with the intensity
+  r = QMIX(balance, QSCALE8(r, intensity), QSCALE8(r2, intensity));
+  g = QMIX(balance, QSCALE8(g, intensity), QSCALE8(g2, intensity));
+  b = QMIX(balance, QSCALE8(b, intensity), QSCALE8(b2, intensity));
+  w = QMIX(balance, QSCALE8(w, intensity), QSCALE8(w2, intensity));
 
-  // scale with the intensity
-  r = intensity * r;
-  g = intensity * g;
-  b = intensity * b;
-  w = intensity * w;
+  F::fill(0, strip.numPixels(), r, g, b, w);
+  showPixels();
+}
+
+// position and width of a slider as angles along the strip, the position is corrected for the width
+static void qslider(int n, uint32_t *position, uint32_t *width) {
+  int64_t half = n / 2;
+  int64_t p = (int64_t)(*position) * (n - 1) * 65536 / 255;   // in pixels, 16.16
+  int64_t w = (int64_t)(*width) * n * 65536 / 255;
 
-  for (int pixel = 0; pixel < strip.numPixels(); pixel++) {
-    if (RGB)
-      strip.setPixelColor(pixel, r, g, b);
-    //else if (RGBW)
-    //  strip.setPixelColor(pixel, r, g, b, w);
-    yield();
+  if (half > 0) {
+    p -= half << 16;
+    p  = p * (((int64_t)n << 16) - w) / 2 / (half << 16);
+    p += half << 16;
   }
-  strip.show();
+  *position = (n > 0 ? p / n : 0);
+  *width    = (n > 0 ? w / n : 0);
 }
 
 /*
@@ -382,64 +332,49 @@ void mode4(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data)
   channel 7 = width    (from 0-255 or 0-360 degrees, relative to the length of the array)
 */
 
-void mode5(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data) {
-  int i = 0, r, g, b, w;
-  float intensity, width, position;
-  if (universe != config.universe)
-    return;
-  if (RGB && (length - config.offset) < 3 + 3)
-    return;
-  if (RGBW && (length - config.offset) < 4 + 3)
-    return;
+template <class F>
+void mode5(uint16_t universe, uint16_t length, uint8_t sequence, const uint8_t * data) {
+  int i = 0, r, g, b, w = 0;
+  uint32_t width, position, step, angle;
+  q16_t intensity;
   r         = data[config.offset + i++];
   g         = data[config.offset + i++];
   b         = data[config.offset + i++];
-  if (RGBW)
+  if (F::white)
     w       = data[config.offset + i++];
-  intensity = data[config.offset + i++] / 255.;
-  position  = data[config.offset + i++] * (strip.numPixels() - 1) / 255.;
-  width     = data[config.offset + i++] * (strip.numPixels() - 0) / 255.;
+  intensity = DMX_TO_Q16(data[config.offset + i++]);
+  position  = data[config.offset + i++];
+  width     = data[config.offset + i++];
 
   if (config.hsv)
     map_hsv_to_rgb(&r, &g, &b);
 
   // scale with the intensity
-  r = intensity * r;
-  g = intensity * g;
-  b = intensity * b;
-  w = intensity * w;
+  r = QSCALE(r, intensity);
+  g = QSCALE(g, intensity);
+  b = QSCALE(b, intensity);
+  w = QSCALE(w, intensity);
 
-  // the position needs to be corrected for the width
-  position -= strip.numPixels() / 2;
-  position /= strip.numPixels() / 2;
-  position *= (strip.numPixels() - width) / 2;
-  position += strip.numPixels() / 2;
+  // express the position and width as phase along the strip, corrected for the width
+  qslider(strip.numPixels(), &position, &width);
 
-  // express the position and with as phase along the strip
-  position *= 360. / strip.numPixels();
-  width    *= 360. / strip.numPixels();
-
-  for (int pixel = 0; pixel < strip.numPixels(); pixel++) {
-    int flip = (config.reverse ? -1 : 1);
-    float phase, balance;
-
-    phase = WRAP180((360. * flip * pixel / strip.numPixels()) * config.position - position);
-    phase = ABS(phase);
+  step  = qstep(config.position, strip.numPixels(), config.reverse);
+  angle = 0;
+  uint8_t *p = strip.getPixels();
+  for (int pixel = 0; pixel < strip.numPixels(); pixel++, p += PIXEL_BYTES, angle += step) {
+    uint32_t phase = AABS((angle >> 16) - position);
+    q16_t balance;
 
     if (width == 0)
       balance = 0;
-    else if (phase <= width / 2)
-      balance = 1;
+    else if (2 * phase <= width)
+      balance = Q16_ONE;
     else
       balance = 0;
 
-    if (RGB)
-      strip.setPixelColor(pixel, balance * r, balance * g, balance * b);
-    //else if (RGBW)
-    //  strip.setPixelColor(pixel, balance * r, balance * g, balance * b, balance * w);
-    yield();
+    F::put(p, QSCALE(r, balance), QSCALE(g, balance), QSCALE(b, balance), QSCALE(w, balance));
   }
-  strip.show();
+  showPixels();
 }
 
 /*
@@ -457,65 +392,60 @@ void mode5(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data)
   channel 11 = width    (from 0-255 or 0-360 degrees, relative to the length of the array)
 */
 
-void mode6(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data) {
-  int i = 0, r, g, b, w, r2, g2, b2, w2;
-  float intensity, width, position;
-  if (universe != config.universe)
-    return;
-  if (RGB && (length - config.offset) < 2 * 3 + 3)
-    return;
-  if (RGBW && (length - config.offset) < 2 * 4 + 3)
-    return;
+template <class F>
+void mode6(uint16_t universe, uint16_t length, uint8_t sequence, const uint8_t * data) {
+  int i = 0, r, g, b, w = 0, r2, g2, b2, w2 = 0;
+  uint32_t width, position, step, angle;
+  q16_t intensity;
   r         = data[config.offset + i++];
   g         = data[config.offset + i++];
   b         = data[config.offset + i++];
-  if (RGBW)
+  if (F::white)
     w       = data[config.offset + i++];
   r2        = data[config.offset + i++];
   g2        = data[config.offset + i++];
   b2        = data[config.offset + i++];
-  if (RGBW)
+  if (F::white)
     w2      = data[config.offset + i++];
-  intensity = data[config.offset + i++] / 255.;
-  position  = data[config.offset + i++] * (strip.numPixels() - 1) / 255.;
-  width     = data[config.offset + i++] * (strip.numPixels() - 0) / 255.;
+  intensity = DMX_TO_Q16(data[config.offset + i++]);
+  position  = data[config.offset + i++];
+  width     = data[config.offset + i++];
 
   if (config.hsv) {
     map_hsv_to_rgb(&r, &g, &b);
     map_hsv_to_rgb(&r2, &g2, &b2);
   }
 
-  // the position needs to be corrected for the width
-  position -= strip.numPixels() / 2;
-  position /= strip.numPixels() / 2;
-  position *= (strip.numPixels() - width) / 2;
-  position += strip.numPixels() / 2;
-
-  // express the position and with as phase along the strip
-  position *= 360. / strip.numPixels();
-  width    *= 360. / strip.numPixels();
-
-  for (int pixel = 0; pixel < strip.numPixels(); pixel++) {
-    int flip = (config.reverse ? -1 : 1);
-    float phase, balance;
-
-    phase = WRAP180((360. * flip * pixel / (strip.numPixels() - 1)) * config.position - position);
-    phase = ABS(phase);
+  // express the position and width as phase along the strip, corrected for the width
+  qslider(strip.numPixels(), &position, &width);
+
+  // scale with the intensity, keeping 8 fractional bits for the balance
+  r  = QSCALE8(r,  intensity);
+  g  = QSCALE8(g,  intensity);
+  b  = QSCALE8(b,  intensity);
+  r2 = QSCALE8(r2, intensity);
+  g2 = QSCALE8(g2, intensity);
+  b2 = QSCALE8(b2, intensity);
+  w  = QSCALE8(w,  intensity);
+  w2 = QSCALE8(w2, intensity);
+
+  step  = qstep(config.position, strip.numPixels() - 1, config.reverse);
+  angle = 0;
+  uint8_t *p = strip.getPixels();
+  for (int pixel = 0; pixel < strip.numPixels(); pixel++, p += PIXEL_BYTES, angle += step) {
+    uint32_t phase = AABS((angle >> 16) - position);
+    q16_t balance;
 
     if (width == 0)
       balance = 0;
-    else if (phase <= width / 2)
-      balance = 1;
+    else if (2 * phase <= width)
+      balance = Q16_ONE;
     else
       balance = 0;
 
-    if (RGB)
-      strip.setPixelColor(pixel, intensity * BALANCE(balance, r, r2), intensity * BALANCE(balance, g, g2), intensity * BALANCE(balance, b, b2));
-    //else if (RGBW)
-    //  strip.setPixelColor(pixel, intensity * BALANCE(balance, r, r2), intensity * BALANCE(balance, g, g2), intensity * BALANCE(balance, b, b2), intensity * BALANCE(balance, w, w2));
-    yield();
+    F::put(p, QMIX(balance, r, r2), QMIX(balance, g, g2), QMIX(balance, b, b2), QMIX(balance, w, w2));
   }
-  strip.show();
+  showPixels();
 }
 
 /*
@@ -530,63 +460,57 @@ void mode6(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data)
   channel 8 = ramp     (from 0-255 or 0-360 degrees, relative to the length of the array)
 */
 
-void mode7(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data) {
-  int i = 0, r, g, b, w;
-  float intensity, position, width, ramp;
-  if (universe != config.universe)
-    return;
-  if (RGB && (length - config.offset) < 3 + 4)
-    return;
-  if (RGBW && (length - config.offset) < 4 + 4)
-    return;
+template <class F>
+void mode7(uint16_t universe, uint16_t length, uint8_t sequence, const uint8_t * data) {
+  int i = 0, r, g, b, w = 0;
+  uint32_t position, width, ramp, step, angle, reciprocal;
+  q16_t intensity;
   r         = data[config.offset + i++];
   g         = data[config.offset + i++];
   b         = data[config.offset + i++];
-  if (RGBW)
+  if (F::white)
     w       = data[config.offset + i++];
-  intensity = data[config.offset + i++] / 255.;
-  position  = data[config.offset + i++] * 360. / 255.;
-  width     = data[config.offset + i++] * 360. / 255.;
-  ramp      = data[config.offset + i++] * 360. / 255.;
+  intensity = DMX_TO_Q16(data[config.offset + i++]);
+  position  = DMX_TO_ANGLE(data[config.offset + i++]);
+  width     = DMX_TO_ANGLE(data[config.offset + i++]);
+  ramp      = DMX_TO_ANGLE(data[config.offset + i++]);
 
   if (config.hsv)
     map_hsv_to_rgb(&r, &g, &b);
 
   // the ramp cannot be too wide
-  if (width < 180)
-    ramp = (ramp < width ? ramp : width);
+  if (width < ANGLE_180)
+    ramp = MIN(ramp, width);
   else
-    ramp = (ramp < (360 - width) ? ramp : (360 - width));
+    ramp = MIN(ramp, ANGLE_360 - width);
+  reciprocal = qreciprocal(2 * ramp);
 
   // scale with the intensity
-  r = intensity * r;
-  g = intensity * g;
-  b = intensity * b;
-  w = intensity * w;
-
-  for (int pixel = 0; pixel < strip.numPixels(); pixel++) {
-    int flip = (config.reverse ? -1 : 1);
-    float phase, balance;
-
-    phase = WRAP180(360. * flip * pixel / (strip.numPixels() - 1) * config.position - position);
-    phase = ABS(phase);
+  r = QSCALE(r, intensity);
+  g = QSCALE(g, intensity);
+  b = QSCALE(b, intensity);
+  w = QSCALE(w, intensity);
+
+  step  = qstep(config.position, strip.numPixels() - 1, config.reverse);
+  angle = 0;
+  uint8_t *p = strip.getPixels();
+  for (int pixel = 0; pixel < strip.numPixels(); pixel++, p += PIXEL_BYTES, angle += step) {
+    // compare in half degrees, the edges are at width/2 -/+ ramp/2
+    uint32_t phase = 2 * AABS((angle >> 16) - position);
+    q16_t balance;
 
     if (width == 0)
       balance = 0;
-    else if (phase < (width / 2. - ramp / 2.))
-      balance = 1;
-    else if (phase > (width / 2. + ramp / 2.))
+    else if (phase + ramp < width)
+      balance = Q16_ONE;
+    else if (phase > width + ramp)
       balance = 0;
-    else if (ramp > 0)
-      balance = ((width / 2. + ramp / 2.) - phase) / ramp;
-
-    if (RGB)
-      strip.setPixelColor(pixel, balance * r, balance * g, balance * b);
-    //else if (RGBW)
-    //  strip.setPixelColor(pixel, balance * r, balance * g, balance * b, balance * w);
-    yield();
+    else
+      balance = qramp(phase + ramp - width, 2 * ramp, reciprocal);
+
+    F::put(p, QSCALE(r, balance), QSCALE(g, balance), QSCALE(b, balance), QSCALE(w, balance));
   }
-  strip.show();
+  showPixels();
 }
 
 /*
@@ -605,29 +529,25 @@ void mode7(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data)
   channel 12 = ramp     (from 0-255 or 0-360 degrees, relative to the length of the array)
 */
 
-void mode8(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data) {
-  int i = 0, r, g, b, w, r2, g2, b2, w2;
-  float intensity, position, width, ramp;
-  if (universe != config.universe)
-    return;
-  if (RGB && (length - config.offset) < 2 * 3 + 4)
-    return;
-  if (RGBW && (length - config.offset) < 2 * 4 + 4)
-    return;
+template <class F>
+void mode8(uint16_t universe, uint16_t length, uint8_t sequence, const uint8_t * data) {
+  int i = 0, r, g, b, w = 0, r2, g2, b2, w2 = 0;
+  uint32_t position, width, ramp, step, angle, reciprocal;
+  q16_t intensity;
   r         = data[config.offset + i++];
   g         = data[config.offset + i++];
   b         = data[config.offset + i++];
-  if (RGBW)
+  if (F::white)
     w       = data[config.offset + i++];
   r2        = data[config.offset + i++];
   g2        = data[config.offset + i++];
   b2        = data[config.offset + i++];
-  if (RGBW)
+  if (F::white)
     w2      = data[config.offset + i++];
-  intensity = data[config.offset + i++] / 255.;
-  position  = data[config.offset + i++] * 360. / 255.;
-  width     = data[config.offset + i++] * 360. / 255.;
-  ramp      = data[config.offset + i++] * 360. / 255.;
+  intensity = DMX_TO_Q16(data[config.offset + i++]);
+  position  = DMX_TO_ANGLE(data[config.offset + i++]);
+  width     = DMX_TO_ANGLE(data[config.offset + i++]);
+  ramp      = DMX_TO_ANGLE(data[config.offset + i++]);
 
   if (config.hsv) {
     map_hsv_to_rgb(&r, &g, &b);
@@ -635,34 +555,42 @@ void mode8(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data)
   }
 
   // the ramp cannot be too wide
-  if (width < 180)
-    ramp = (ramp < width ? ramp : width);
+  if (width < ANGLE_180)
+    ramp = MIN(ramp, width);
   else
-    ramp = (ramp < (360 - width) ? ramp : (360 - width));
-
-  for (int pixel = 0; pixel < strip.numPixels(); pixel++) {
-    int flip = (config.reverse ? -1 : 1);
-    float phase, balance;
-
-    phase = WRAP180(360. * flip * pixel / (strip.numPixels() - 1) * config.position - position);
-    phase = ABS(phase);
+    ramp = MIN(ramp, ANGLE_360 - width);
+  reciprocal = qreciprocal(2 * ramp);
+
+  // scale with the intensity, keeping 8 fractional bits for the balance
+  r  = QSCALE8(r,  intensity);
+  g  = QSCALE8(g,  intensity);
+  b  = QSCALE8(b,  intensity);
+  r2 = QSCALE8(r2, intensity);
+  g2 = QSCALE8(g2, intensity);
+  b2 = QSCALE8(b2, intensity);
+  w  = QSCALE8(w,  intensity);
+  w2 = QSCALE8(w2, intensity);
+
+  step  = qstep(config.position, strip.numPixels() - 1, config.reverse);
+  angle = 0;
+  uint8_t *p = strip.getPixels();
+  for (int pixel = 0; pixel < strip.numPixels(); pixel++, p += PIXEL_BYTES, angle += step) {
+    // compare in half degrees, the edges are at width/2 -/+ ramp/2
+    uint32_t phase = 2 * AABS((angle >> 16) - position);
+    q16_t balance;
 
     if (width == 0)
       balance = 0;
-    else if (phase < (width / 2. - ramp / 2.))
-      balance = 1;
-    else if (phase > (width / 2. + ramp / 2.))
+    else if (phase + ramp < width)
+      balance = Q16_ONE;
+    else if (phase > width + ramp)
       balance = 0;
-    else if (ramp > 0)
-      balance = ((width / 2. + ramp / 2.) - phase) / ramp;
-
-    if (RGB)
-      strip.setPixelColor(pixel, intensity * BALANCE(balance, r, r2), intensity * BALANCE(balance, g, g2), intensity * BALANCE(balance, b, b2));
-    //else if (RGBW)
-    //  strip.setPixelColor(pixel, intensity * BALANCE(balance, r, r2), intensity * BALANCE(balance, g, g2), intensity * BALANCE(balance, b, b2), intensity * BALANCE(balance, w, w2));
-    yield();
+    else
+      balance = qramp(phase + ramp - width, 2 * ramp, reciprocal);
+
+    F::put(p, QMIX(balance, r, r2), QMIX(balance, g, g2), QMIX(balance, b, b2), QMIX(balance, w, w2));
   }
-  strip.show();
+  showPixels();
 }
 
 /*
@@ -677,72 +605,66 @@ void mode8(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data)
   channel 8 = ramp
 */
 
-void mode9(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data) {
-  int i = 0, r, g, b, w;
-  float intensity, speed, width, ramp, phase;
-  if (universe != config.universe)
-    return;
-  if (RGB && (length - config.offset) < 3 + 4)
-    return;
-  if (RGBW && (length - config.offset) < 4 + 4)
-    return;
+template <class F>
+void mode9(uint16_t universe, uint16_t length, uint8_t sequence, const uint8_t * data) {
+  int i = 0, r, g, b, w = 0;
+  uint32_t speed, width, ramp, phase, step, angle, reciprocal;
+  q16_t intensity;
   r         = data[config.offset + i++];
   g         = data[config.offset + i++];
   b         = data[config.offset + i++];
-  if (RGBW)
+  if (F::white)
     w       = data[config.offset + i++];
-  intensity = 1. * data[config.offset + i++] / 255.;
-  speed     = 1. * data[config.offset + i++] / config.speed;
-  width     = 1. * data[config.offset + i++] * 360. / 255.;
-  ramp      = 1. * data[config.offset + i++] * 360. / 255.;
+  intensity = DMX_TO_Q16(data[config.offset + i++]);
+  speed     = data[config.offset + i++];
+  width     = DMX_TO_ANGLE(data[config.offset + i++]);
+  ramp      = DMX_TO_ANGLE(data[config.offset + i++]);
 
   if (config.hsv)
     map_hsv_to_rgb(&r, &g, &b);
 
   // the ramp cannot be too wide
-  if (width < 180)
-    ramp = (ramp < width ? ramp : width);
+  if (width < ANGLE_180)
+    ramp = MIN(ramp, width);
   else
-    ramp = (ramp < (360 - width) ? ramp : (360 - width));
+    ramp = MIN(ramp, ANGLE_360 - width);
+  reciprocal = qreciprocal(2 * ramp);
 
   // scale with the intensity
-  r = intensity * r;
-  g = intensity * g;
-  b = intensity * b;
-  w = intensity * w;
+  r = QSCALE(r, intensity);
+  g = QSCALE(g, intensity);
+  b = QSCALE(b, intensity);
+  w = QSCALE(w, intensity);
 
   // determine the current phase in the temporal cycle
-  phase = (speed * millis()) * 360. / 1000.;
+  phase = qphase(speed, config.speed, millis());
 
   // prevent rolling back
-  if (WRAP180(phase - prev) < 0)
+  if (AWRAP180(phase - prev) < 0)
     phase = prev;
   else
     prev = phase;
 
-  for (int pixel = 0; pixel < strip.numPixels(); pixel++) {
-    int flip = (config.reverse ? -1 : 1);
-    float position, balance;
-
-    position = WRAP180(360. * flip * pixel / (strip.numPixels() - 1) * config.position - phase);
-    position = ABS(position);
+  step  = qstep(config.position, strip.numPixels() - 1, config.reverse);
+  angle = 0;
+  uint8_t *p = strip.getPixels();
+  for (int pixel = 0; pixel < strip.numPixels(); pixel++, p += PIXEL_BYTES, angle += step) {
+    // compare in half degrees, the edges are at width/2 -/+ ramp/2
+    uint32_t position = 2 * AABS((angle >> 16) - phase);
+    q16_t balance;
 
     if (width == 0)
       balance = 0;
-    else if (position < (width / 2. - ramp / 2.))
-      balance = 1;
-    else if (position > (width / 2. + ramp / 2.))
+    else if (position + ramp < width)
+      balance = Q16_ONE;
+    else if (position > width + ramp)
       balance = 0;
-    else if (position > 0)
-      balance = ((width / 2. + ramp / 2.) - position) / ramp;
-
-    if (RGB)
-      strip.setPixelColor(pixel, balance * r, balance * g, balance * b);
-    //else if (RGBW)
-    //  strip.setPixelColor(pixel, balance * r, balance * g, balance * b, balance * w);
-    yield();
+    else
+      balance = qramp(position + ramp - width, 2 * ramp, reciprocal);
+
+    F::put(p, QSCALE(r, balance), QSCALE(g, balance), QSCALE(b, balance), QSCALE(w, balance));
   }
-  strip.show();
+  showPixels();
 };
 
 /*
@@ -761,29 +683,25 @@ void mode9(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data)
   channel 12 = ramp
 */
 
-void mode10(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data) {
-  int i = 0, r, g, b, w, r2, g2, b2, w2;
-  float intensity, speed, width, ramp, phase;
-  if (universe != config.universe)
-    return;
-  if (RGB && (length - config.offset) < 2 * 3 + 4)
-    return;
-  if (RGBW && (length - config.offset) < 2 * 4 + 4)
-    return;
+template <class F>
+void mode10(uint16_t universe, uint16_t length, uint8_t sequence, const uint8_t * data) {
+  int i = 0, r, g, b, w = 0, r2, g2, b2, w2 = 0;
+  uint32_t speed, width, ramp, phase, step, angle, reciprocal;
+  q16_t intensity;
   r         = data[config.offset + i++];
   g         = data[config.offset + i++];
   b         = data[config.offset + i++];
-  if (RGBW)
+  if (F::white)
     w       = data[config.offset + i++];
   r2        = data[config.offset + i++];
   g2        = data[config.offset + i++];
   b2        = data[config.offset + i++];
-  if (RGBW)
+  if (F::white)
     w2      = data[config.offset + i++];
-  intensity = 1. * data[config.offset + i++] / 255.;
-  speed     = 1. * data[config.offset + i++] / config.speed;
-  width     = 1. * data[config.offset + i++] * 360. / 255.;
-  ramp      = 1. * data[config.offset + i++] * 360. / 255.;
+  intensity = DMX_TO_Q16(data[config.offset + i++]);
+  speed     = data[config.offset + i++];
+  width     = DMX_TO_ANGLE(data[config.offset + i++]);
+  ramp      = DMX_TO_ANGLE(data[config.offset + i++]);
 
   if (config.hsv) {
     map_hsv_to_rgb(&r, &g, &b);
@@ -791,43 +709,51 @@ void mode10(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data
   }
 
   // the ramp cannot be too wide
-  if (width < 180)
-    ramp = (ramp < width ? ramp : width);
+  if (width < ANGLE_180)
+    ramp = MIN(ramp, width);
   else
-    ramp = (ramp < (360 - width) ? ramp : (360 - width));
+    ramp = MIN(ramp, ANGLE_360 - width);
+  reciprocal = qreciprocal(2 * ramp);
+
+  // scale with the intensity, keeping 8 fractional bits for the balance
+  r  = QSCALE8(r,  intensity);
+  g  = QSCALE8(g,  intensity);
+  b  = QSCALE8(b,  intensity);
+  r2 = QSCALE8(r2, intensity);
+  g2 = QSCALE8(g2, intensity);
+  b2 = QSCALE8(b2, intensity);
+  w  = QSCALE8(w,  intensity);
+  w2 = QSCALE8(w2, intensity);
 
   // determine the current phase in the temporal cycle
-  phase = (speed * millis()) * 360. / 1000.;
+  phase = qphase(speed, config.speed, millis());
 
   // prevent rolling back
-  if (WRAP180(phase - prev) < 0)
+  if (AWRAP180(phase - prev) < 0)
     phase = prev;
   else
     prev = phase;
 
-  for (int pixel = 0; pixel < strip.numPixels(); pixel++) {
-    int flip = (config.reverse ? -1 : 1);
-    float position, balance;
-
-    position = WRAP180((360. * flip * pixel / (strip.numPixels() - 1)) * config.position - phase);
-    position = ABS(position);
+  step  = qstep(config.position, strip.numPixels() - 1, config.reverse);
+  angle = 0;
+  uint8_t *p = strip.getPixels();
+  for (int pixel = 0; pixel < strip.numPixels(); pixel++, p += PIXEL_BYTES, angle += step) {
+    // compare in half degrees, the edges are at width/2 -/+ ramp/2
+    uint32_t position = 2 * AABS((angle >> 16) - phase);
+    q16_t balance;
 
     if (width == 0)
       balance = 0;
-    else if (position < (width / 2. - ramp / 2.))
-      balance = 1;
-    else if (position > (width / 2. + ramp / 2.))
+    else if (position + ramp < width)
+      balance = Q16_ONE;
+    else if (position > width + ramp)
       balance = 0;
-    else if (position > 0)
-      balance = ((width / 2. + ramp / 2.) - position) / ramp;
-
-    if (RGB)
-      strip.setPixelColor(pixel, intensity * BALANCE(balance, r, r2), intensity * BALANCE(balance, g, g2), intensity * BALANCE(balance, b, b2));
-    //else if (RGBW)
-    //  strip.setPixelColor(pixel, intensity * BALANCE(balance, r, r2), intensity * BALANCE(balance, g, g2), intensity * BALANCE(balance, b, b2), intensity * BALANCE(balance, w, w2));
-    yield();
+    else
+      balance = qramp(position + ramp - width, 2 * ramp, reciprocal);
+
+    F::put(p, QMIX(balance, r, r2), QMIX(balance, g, g2), QMIX(balance, b, b2), QMIX(balance, w, w2));
   }
-  strip.show();
+  showPixels();
 };
 
 /*
@@ -837,32 +763,25 @@ void mode10(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data
   channel 3 = position
 */
 
-void mode11(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data) {
-  int i = 0;
-  float saturation, value, position;
+template <class F>
+void mode11(uint16_t universe, uint16_t length, uint8_t sequence, const uint8_t * data) {
+  int i = 0, saturation, value;
+  uint32_t position, step, angle;
 
-  if (universe != config.universe)
-    return;
-  if ((length - config.offset) < 3)
-    return;
-  saturation = 1. * data[config.offset + i++];
-  value      = 1. * data[config.offset + i++] ;
-  position   = 1. * data[config.offset + i++] * 360. / 255.;
-
-  for (int pixel = 0; pixel < strip.numPixels(); pixel++) {
-    int flip = (config.reverse ? -1 : 1);
-    float phase = WRAP360((360. * flip * pixel / strip.numPixels()) * config.position - position);
-
-    int r, g, b;
-    r = phase;           // hue, between 0-360
-    g = saturation;      // saturation, between 0-255
-    b = value;           // value, between 0-255
-    map_hsv_to_rgb(&r, &g, &b);
+  saturation = data[config.offset + i++];
+  value      = data[config.offset + i++];
+  position   = DMX_TO_ANGLE(data[config.offset + i++]);
 
-    strip.setPixelColor(pixel, r, g, b);
-    yield();
+  step  = qstep(config.position, strip.numPixels(), config.reverse);
+  angle = 0;
+  uint8_t *p = strip.getPixels();
+  for (int pixel = 0; pixel < strip.numPixels(); pixel++, p += PIXEL_BYTES, angle += step) {
+    uint8_t r, g, b;
+    hsv2rgb16((angle >> 16) - position, saturation, value, &r, &g, &b);   // hue as angle, 0-360
+
+    F::put(p, r, g, b);
   }
-  strip.show();
+  showPixels();
 };
 
 /*
@@ -872,62 +791,108 @@ void mode11(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data
   channel 3 = speed
 */
 
-void mode12(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data) {
-  int i = 0;
-  float saturation, value, speed, phase;
+template <class F>
+void mode12(uint16_t universe, uint16_t length, uint8_t sequence, const uint8_t * data) {
+  int i = 0, saturation, value;
+  uint32_t speed, phase, step, angle;
 
-  if (universe != config.universe)
-    return;
-  if ((length - config.offset) < 3)
-    return;
-  saturation = 1. * data[config.offset + i++];
-  value      = 1. * data[config.offset + i++] ;
-  speed      = 1. * data[config.offset + i++] / config.speed;
+  saturation = data[config.offset + i++];
+  value      = data[config.offset + i++];
+  speed      = data[config.offset + i++];
 
   // determine the current phase in the temporal cycle
-  phase = (speed * millis()) * 360. / 1000.;
+  phase = qphase(speed, config.speed, millis());
 
   // prevent rolling back
-  if (WRAP180(phase - prev) < 0)
+  if (AWRAP180(phase - prev) < 0)
     phase = prev;
   else
     prev = phase;
 
-  for (int pixel = 0; pixel < strip.numPixels(); pixel++) {
-    int flip = (config.reverse ? -1 : 1);
-    float position = WRAP360((360. * flip * pixel / strip.numPixels()) * config.position - phase);
+  step  = qstep(config.position, strip.numPixels(), config.reverse);
+  angle = 0;
+  uint8_t *p = strip.getPixels();
+  for (int pixel = 0; pixel < strip.numPixels(); pixel++, p += PIXEL_BYTES, angle += step) {
+    uint8_t r, g, b;
+    hsv2rgb16((angle >> 16) - phase, saturation, value, &r, &g, &b);   // hue as angle, 0-360
 
-    int r, g, b;
-    r = position;        // hue, between 0-360
-    g = saturation;      // saturation, between 0-255
-    b = value;           // value, between 0-255
-    map_hsv_to_rgb(&r, &g, &b);
-
-    strip.setPixelColor(pixel, r, g, b);
-    yield();
+    F::put(p, r, g, b);
   }
-  strip.show();
+  showPixels();
 };
 
+/*
+  mode 13: individual pixel control with 16 bits per color, high byte first
+  channel 1  = pixel 1 red
+  channel 2  = pixel 1 red fine
+  channel 3  = pixel 1 green
+  channel 4  = pixel 1 green fine
+  channel 5  = pixel 1 blue
+  channel 6  = pixel 1 blue fine
+  channel 7  = pixel 1 white
+  channel 8  = pixel 1 white fine
+  channel 9  = pixel 2 red
+  etc.
+  The colors are sent with the 5-bit brightness of the APA102, see apa102.h.
+  There is no HSV mapping in this mode.
+*/
 
-/************************************************************************************/
-/************************************************************************************/
-/************************************************************************************/
+template <class F>
+void mode13(uint16_t universe, uint16_t length, uint8_t sequence, const uint8_t * data) {
+  uint16_t *hdr = hdrPixels();
+
+  // the strip buffer gets the high bytes, so that the pixels read back as in the other modes
+  const uint8_t *d = data + config.offset;
+  uint8_t *p = strip.getPixels();
+  for (int pixel = 0; pixel < strip.numPixels(); pixel++, p += PIXEL_BYTES, hdr += 3) {
+    uint32_t r = (d[0] << 8) | d[1];
+    uint32_t g = (d[2] << 8) | d[3];
+    uint32_t b = (d[4] << 8) | d[5];
+    d += 6;
+    if (F::white) {
+      uint32_t w = (d[0] << 8) | d[1];
+      d += 2;
+      r = MIN(r + w, 65535);
+      g = MIN(g + w, 65535);
+      b = MIN(b + w, 65535);
+    }
+    hdr[0] = r;
+    hdr[1] = g;
+    hdr[2] = b;
+    F::put(p, r >> 8, g >> 8, b >> 8);
+  }
+  hdrShow();
+}
 
-void mode13(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data) {};
-void mode14(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data) {};
-void mode15(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data) {};
-void mode16(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data) {};
+// the kernels for all pixel formats, the registry selects one when the configuration changes
+#define INSTANTIATE(mode) \
+  template void mode<FormatRGB>(uint16_t, uint16_t, uint8_t, const uint8_t *); \
+  template void mode<FormatRGBW>(uint16_t, uint16_t, uint8_t, const uint8_t *);
+
+INSTANTIATE(mode0)
+INSTANTIATE(mode1)
+INSTANTIATE(mode2)
+INSTANTIATE(mode3)
+INSTANTIATE(mode4)
+INSTANTIATE(mode5)
+INSTANTIATE(mode6)
+INSTANTIATE(mode7)
+INSTANTIATE(mode8)
+INSTANTIATE(mode9)
+INSTANTIATE(mode10)
+INSTANTIATE(mode11)
+INSTANTIATE(mode12)
+INSTANTIATE(mode13)
 
 /************************************************************************************/
 /************************************************************************************/
 /************************************************************************************/
 
 void singleLed(byte r, byte g, byte b, byte w) {
-  fullBlack();
+  fillPixels(0, strip.numPixels(), 0, 0, 0);
   // strip.setPixelColor(0, strip.Color(r, g, b, w ) );
   strip.setPixelColor(0, strip.Color(r, g, b ) );
-  strip.show();
+  showPixels();
 }
 
 void singleRed() {
@@ -976,46 +941,37 @@ uint32_t Wheel(byte WheelPos) {
 
 
 void fullRed() {
-  Serial.println("fullRed");
-  for (uint16_t i = 0; i < strip.numPixels(); i++) {
-    strip.setPixelColor(i, strip.Color(255, 0, 0 ) );
-  }
-  strip.show();
+  LOG_D(LOG_OUTPUT, "fullRed");
+  fillPixels(0, strip.numPixels(), 255, 0, 0);
+  showPixels();
 }
 
 void fullGreen() {
-  for (uint16_t i = 0; i < strip.numPixels(); i++) {
-    strip.setPixelColor(i, strip.Color(0, 255, 0 ) );
-  }
-  strip.show();
+  fillPixels(0, strip.numPixels(), 0, 255, 0);
+  showPixels();
 }
 
 void fullBlue() {
-  for (uint16_t i = 0; i < strip.numPixels(); i++) {
-    strip.setPixelColor(i, strip.Color(0, 0, 255 ) );
-  }
-  strip.show();
+  fillPixels(0, strip.numPixels(), 0, 0, 255);
+  showPixels();
 }
 
 void fullWhite() {
-  for (uint16_t i = 0; i < strip.numPixels(); i++) {
-    strip.setPixelColor(i, strip.Color(0, 0, 0 ) );
-  }
-  strip.show();
+  fillPixels(0, strip.numPixels(), 0, 0, 0);
+  showPixels();
 }
 
 void fullBlack() {
-  for (uint16_t i = 0; i < strip.numPixels(); i++) {
-    strip.setPixelColor(i, strip.Color(0, 0, 0 ) );
-  }
-  strip.show();
+  fillPixels(0, strip.numPixels(), 0, 0, 0);
+  showPixels();
 }
 
 // Fill the dots one after the other with a specific color
 void colorWipe(uint8_t wait, uint32_t c) {
   for (uint16_t i = 0; i < strip.numPixels(); i++) {
     strip.setPixelColor(i, c);
-    strip.show();
+    showPixels();
+    outputFlush();
     delay(wait);
   }
 }
@@ -1026,14 +982,16 @@ void pulseWhite(uint8_t wait) {
       strip.setPixelColor(i, strip.Color(0, 0, 0 ) );
     }
     delay(wait);
-    strip.show();
+    showPixels();
+    outputFlush();
   }
   for (int j = 255; j >= 0 ; j--) {
     for (uint16_t i = 0; i < strip.numPixels(); i++) {
       strip.setPixelColor(i, strip.Color(0, 0, 0 ) );
     }
     delay(wait);
-    strip.show();
+    showPixels();
+    outputFlush();
   }
 }
 
@@ -1060,7 +1018,8 @@ void rainbowFade2White(uint8_t wait, int rainbowLoops, int whiteLoops) {
       else if (k == rainbowLoops - 1 && j > 255 - fadeMax ) {
         fadeVal--;
       }
-      strip.show();
+      showPixels();
+      outputFlush();
       delay(wait);
     }
 
@@ -1114,7 +1073,8 @@ void whiteOverRainbow(uint8_t wait, uint8_t whiteSpeed, uint8_t whiteLength ) {
       if (loopNum == loops) return;
       head %= strip.numPixels();
       tail %= strip.numPixels();
-      strip.show();
+      showPixels();
+      outputFlush();
       delay(wait);
     }
   }
@@ -1128,7 +1088,8 @@ void rainbowCycle(uint8_t wait) {
     for (i = 0; i < strip.numPixels(); i++) {
       strip.setPixelColor(i, Wheel(((i * 256 / strip.numPixels()) + j) & 255));
     }
-    strip.show();
+    showPixels();
+    outputFlush();
     delay(wait);
   }
 }
@@ -1139,19 +1100,16 @@ void rainbow(uint8_t wait) {
     for (i = 0; i < strip.numPixels(); i++) {
       strip.setPixelColor(i, Wheel((i + j) & 255));
     }
-    strip.show();
+    showPixels();
+    outputFlush();
     delay(wait);
   }
 }
 
 void map_hsv_to_rgb(int *r, int *g, int *b) {
-  hsv in;
-  rgb out;
-  in.h = 360. * (*r) / 256.;
-  in.s =   1. * (*g) / 255.;
-  in.v =   1. * (*b) / 255.;
-  out = hsv2rgb(in);
-  (*r) = out.r * 255;
-  (*g) = out.g * 255;
-  (*b) = out.b * 255;
+  uint8_t red, green, blue;
+  hsv2rgb8(*r, *g, *b, &red, &green, &blue);
+  (*r) = red;
+  (*g) = green;
+  (*b) = blue;
 }
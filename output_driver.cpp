@@ -0,0 +1,217 @@
+#include <SPI.h>
+#include <esp8266_peri.h>
+
+#include "output_driver.h"
+#include "dotstar_strip.h"
+#include "pixel_arena.h"
+#include "setup_ota.h"
+
+extern Config config;
+
+// data and clock, output 0 is driven by the SPI hardware
+static const uint8_t pins[OUTPUT_COUNT][2] = {
+  { MOSI, SCK },
+  { OUTPUT1_DATA, OUTPUT1_CLOCK },
+  { OUTPUT2_DATA, OUTPUT2_CLOCK },
+};
+
+struct Output {
+  const uint8_t *frames;   // the LED frames of the slice in the front buffer
+  uint16_t count;
+  uint32_t length;         // bytes on the wire: start frame, LED frames and end frame
+  uint32_t sent;
+};
+
+static uint8_t *front = arena.output[0], *back = arena.output[1];
+static uint16_t backCount = 0;     // pixels in the back buffer
+static Output outputs[OUTPUT_COUNT];
+static uint8_t pinsUsed = 0;   // bit k: the pins of output k are driven
+static bool sending = false;
+static uint32_t tic_output = 0;
+
+uint32_t outputTime = 0;
+uint32_t outputWaits = 0;
+
+// the pins of a bit-banged output are only driven while it has a slice, the board may use them
+// for something else, and GPIO15 has to be low at boot
+static void setupPins(void) {
+  for (uint8_t k = 1; k < OUTPUT_COUNT; k++) {
+    bool used = (k == 1 ? config.slice1 : config.slice2) > 0;
+    if (used == ((pinsUsed >> k) & 1))
+      continue;
+    if (used) {
+      GPOC = (1 << pins[k][0]) | (1 << pins[k][1]);
+      pinMode(pins[k][0], OUTPUT);
+      pinMode(pins[k][1], OUTPUT);
+      pinsUsed |= 1 << k;
+    }
+    else {
+      pinMode(pins[k][0], INPUT);
+      pinMode(pins[k][1], INPUT);
+      pinsUsed &= ~(1 << k);
+    }
+  }
+}
+
+void outputBegin(void) {
+  setupPins();
+}
+
+uint8_t *outputFrames(uint16_t count) {
+  if (count > MAX_PIXELS)
+    return NULL;
+  backCount = count;
+  return back;
+}
+
+// len bytes of the wire frame of an output, starting at byte i
+static void streamBytes(const Output *o, uint32_t i, uint8_t *dst, uint32_t len) {
+  uint32_t end = 4 + PIXEL_BYTES * (uint32_t)o->count;
+  while (len > 0) {
+    uint32_t n;
+    if (i < 4) {
+      n = min(len, 4 - i);
+      memset(dst, 0x00, n);
+    }
+    else if (i < end) {
+      n = min(len, end - i);
+      memcpy(dst, o->frames + i - 4, n);
+    }
+    else {
+      n = len;
+      memset(dst, 0xFF, n);
+    }
+    i += n;
+    dst += n;
+    len -= n;
+  }
+}
+
+// start the next chunk of output 0, the FIFO is idle
+static void sendChunk(void) {
+  Output *o = &outputs[0];
+  uint32_t words[OUTPUT_CHUNK / 4];
+  uint32_t len = min(o->length - o->sent, (uint32_t)OUTPUT_CHUNK);
+  uint32_t bits = 8 * len - 1;
+  streamBytes(o, o->sent, (uint8_t *)words, len);
+  SPI1U1 = (SPI1U1 & ~((SPIMMOSI << SPILMOSI) | (SPIMMISO << SPILMISO))) | (bits << SPILMOSI) | (bits << SPILMISO);
+  volatile uint32_t *fifo = &SPI1W0;
+  for (uint32_t i = 0; i < (len + 3) / 4; i++)
+    fifo[i] = words[i];
+  SPI1CMD |= SPIBUSY;
+  o->sent += len;
+}
+
+static inline void refill(void) {
+  if (outputs[0].sent < outputs[0].length && !(SPI1CMD & SPIBUSY))
+    sendChunk();
+}
+
+static bool gpioPending(void) {
+  for (uint8_t k = 1; k < OUTPUT_COUNT; k++)
+    if (outputs[k].sent < outputs[k].length)
+      return true;
+  return false;
+}
+
+// the next byte on every bit-banged output that still has bytes to send, MSB first,
+// the data pins change while the clocks are low and the pixels latch them on the rising edge
+static void bitbangByte(void) {
+  uint8_t bytes[OUTPUT_COUNT];
+  uint32_t clocks = 0, data = 0;
+  for (uint8_t k = 1; k < OUTPUT_COUNT; k++) {
+    Output *o = &outputs[k];
+    bytes[k] = 0;
+    if (o->sent < o->length) {
+      streamBytes(o, o->sent++, &bytes[k], 1);
+      clocks |= 1 << pins[k][1];
+      data |= 1 << pins[k][0];
+    }
+  }
+  for (uint8_t bit = 0x80; bit; bit >>= 1) {
+    uint32_t set = 0;
+    for (uint8_t k = 1; k < OUTPUT_COUNT; k++)
+      if (bytes[k] & bit)
+        set |= 1 << pins[k][0];
+    GPOC = clocks | (data & ~set);
+    GPOS = set;
+    GPOS = clocks;
+  }
+  GPOC = clocks;
+}
+
+// the FIFO, then up to OUTPUT_CHUNK bytes on the bit-banged outputs with the FIFO refilled in between
+static void step(void) {
+  refill();
+  for (uint16_t i = 0; i < OUTPUT_CHUNK && gpioPending(); i++) {
+    bitbangByte();
+    refill();
+  }
+}
+
+static bool done(void) {
+  return outputs[0].sent >= outputs[0].length && !gpioPending() && !(SPI1CMD & SPIBUSY);
+}
+
+// the last byte is out
+static void finish(void) {
+  outputTime = micros() - tic_output;
+  sending = false;
+}
+
+void outputPoll(void) {
+  if (!sending)
+    return;
+  step();
+  if (done())
+    finish();
+}
+
+bool outputBusy(void) {
+  return sending && !done();
+}
+
+void outputFlush(void) {
+  while (sending) {
+    step();
+    if (done())
+      finish();
+  }
+}
+
+uint16_t outputSlice(uint8_t output) {
+  return (output < OUTPUT_COUNT ? outputs[output].count : 0);
+}
+
+void outputSend(void) {
+  if (outputBusy())
+    outputWaits++;
+  outputFlush();
+  setupPins();
+
+  uint8_t *tmp = front;
+  front = back;
+  back = tmp;
+
+  // the slices of the bit-banged outputs are taken from the end of the strip
+  uint16_t slices[OUTPUT_COUNT];
+  uint16_t rest = backCount;
+  slices[2] = min((uint16_t)constrain(config.slice2, 0, 65535), rest);
+  rest -= slices[2];
+  slices[1] = min((uint16_t)constrain(config.slice1, 0, 65535), rest);
+  rest -= slices[1];
+  slices[0] = rest;
+
+  const uint8_t *frames = front;
+  for (uint8_t k = 0; k < OUTPUT_COUNT; k++) {
+    Output *o = &outputs[k];
+    o->frames = frames;
+    o->count = slices[k];
+    o->length = (slices[k] ? DOTSTAR_FRAME_BYTES(slices[k]) : 0);
+    o->sent = 0;
+    frames += PIXEL_BYTES * slices[k];
+  }
+  sending = true;
+  tic_output = micros();
+  step();
+}
@@ -0,0 +1,66 @@
+#ifndef _OUTPUT_DRIVER_H_
+#define _OUTPUT_DRIVER_H_
+
+#include <Arduino.h>
+
+/*
+  Double-buffered output of APA102 frames on up to OUTPUT_COUNT strips. A
+  frame is encoded into the back buffer and swapped to the front when it
+  is sent. The LED frames of the logical strip are split into consecutive
+  slices, one per output, and every output sends its own start frame, its
+  slice and its end frame of 4 + count / 16 bytes of 0xFF.
+
+  Output 0 is the HSPI hardware FIFO: its frame goes out in chunks of up to
+  64 bytes, every call to outputPoll() refills the FIFO when the previous
+  chunk is out. The other outputs are bit-banged on two GPIO pins each, all
+  of them in lockstep, up to OUTPUT_CHUNK bytes per call, and the FIFO is
+  refilled between those bytes. The outputs are therefore on the wire at
+  the same time, and a frame takes as long as the longest output rather
+  than the sum of all. APA102 pixels are clocked by the master, so a gap
+  between two chunks does no harm.
+
+  The loop keeps parsing packets and serving web requests between the
+  calls, and the renderer can fill the next frame while the current one is
+  on the wire. Only a frame that is sent before the previous one is out
+  waits for it, which is counted in outputWaits.
+
+  config.slice1   pixels at the end of the strip on output 1, 0 if unused
+  config.slice2   pixels at the end of the strip on output 2, after output 1
+  Output 0 takes the pixels in front of them.
+*/
+
+#define OUTPUT_CHUNK 64   // bytes, the SPI1W0-SPI1W15 FIFO
+#define OUTPUT_COUNT 3    // hardware SPI and two bit-banged outputs
+
+// data and clock of the bit-banged outputs, output 0 is HMOSI (GPIO13) and HSCLK (GPIO14)
+#define OUTPUT1_DATA  4   // D2
+#define OUTPUT1_CLOCK 5   // D1
+#define OUTPUT2_DATA  12  // D6, HMISO is not used by the strip
+#define OUTPUT2_CLOCK 15  // D8
+
+// the pins of the bit-banged outputs that have a slice, after strip.begin(),
+// outputSend() sets them up or releases them when the slices change
+void outputBegin(void);
+
+// the LED frames of the back buffer for count pixels, NULL if there are more than MAX_PIXELS
+uint8_t *outputFrames(uint16_t count);
+
+// send the back buffer, it becomes the front buffer
+void outputSend(void);
+
+// refill the FIFO and bit-bang the next bytes, call as often as possible
+void outputPoll(void);
+
+// a frame is still on the wire
+bool outputBusy(void);
+
+// wait until the current frame is completely out
+void outputFlush(void);
+
+// pixels of the last frame sent on each output
+uint16_t outputSlice(uint8_t output);
+
+extern uint32_t outputTime;    // us from the first to the last byte of the last complete frame
+extern uint32_t outputWaits;   // frames that had to wait for the previous one
+
+#endif
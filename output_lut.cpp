@@ -0,0 +1,169 @@
+#include "output_lut.h"
+#include "pixel_ops.h"
+#include "setup_ota.h"
+#include "pixel_arena.h"
+
+extern Config config;
+
+// 65535 * (i / 255) ^ 2.8
+static const uint16_t gamma16[256] PROGMEM = {
+      0,     0,     0,     0,     1,     1,     2,     3,
+      4,     6,     8,    10,    13,    16,    19,    24,
+     28,    33,    39,    46,    53,    60,    69,    78,
+     88,    98,   110,   122,   135,   149,   164,   179,
+    196,   214,   232,   252,   273,   295,   317,   341,
+    366,   393,   420,   449,   478,   510,   542,   575,
+    610,   647,   684,   723,   764,   806,   849,   894,
+    940,   988,  1037,  1088,  1140,  1194,  1250,  1307,
+   1366,  1427,  1489,  1553,  1619,  1686,  1756,  1827,
+   1900,  1975,  2051,  2130,  2210,  2293,  2377,  2463,
+   2552,  2642,  2734,  2829,  2925,  3024,  3124,  3227,
+   3332,  3439,  3548,  3660,  3774,  3890,  4008,  4128,
+   4251,  4376,  4504,  4634,  4766,  4901,  5038,  5177,
+   5319,  5464,  5611,  5760,  5912,  6067,  6224,  6384,
+   6546,  6711,  6879,  7049,  7222,  7397,  7576,  7757,
+   7941,  8128,  8317,  8509,  8704,  8902,  9103,  9307,
+   9514,  9723,  9936, 10151, 10370, 10591, 10816, 11043,
+  11274, 11507, 11744, 11984, 12227, 12473, 12722, 12975,
+  13230, 13489, 13751, 14017, 14285, 14557, 14833, 15111,
+  15393, 15678, 15967, 16259, 16554, 16853, 17155, 17461,
+  17770, 18083, 18399, 18719, 19042, 19369, 19700, 20034,
+  20372, 20713, 21058, 21407, 21759, 22115, 22475, 22838,
+  23206, 23577, 23952, 24330, 24713, 25099, 25489, 25884,
+  26282, 26683, 27089, 27499, 27913, 28330, 28752, 29178,
+  29608, 30041, 30479, 30921, 31367, 31818, 32272, 32730,
+  33193, 33660, 34131, 34606, 35085, 35569, 36057, 36549,
+  37046, 37547, 38052, 38561, 39075, 39593, 40116, 40643,
+  41175, 41711, 42251, 42796, 43346, 43899, 44458, 45021,
+  45588, 46161, 46737, 47319, 47905, 48495, 49091, 49691,
+  50295, 50905, 51519, 52138, 52761, 53390, 54023, 54661,
+  55303, 55951, 56604, 57261, 57923, 58590, 59262, 59939,
+  60621, 61308, 62000, 62697, 63399, 64106, 64818, 65535,
+};
+
+// indexed by the position of the color in the LED frame minus one, rounded, or cut off while dithering
+static uint8_t lut[3][256];
+static bool identity = true;
+static bool dither = false;
+
+// while dithering the fractions of the tables, and those that are still owed to each subpixel, in 1/256
+static uint8_t (*fraction)[256] = arena.dither.fraction;
+static uint8_t *error = arena.dither.error;
+static uint16_t errorCount = 0;
+static uint32_t scale16[3];   // brightness and balance of r, g, b, 65536 is full scale
+
+uint8_t lutGeneration = 0;
+
+static void buildChannel(uint8_t c, uint32_t *scale16, int balance) {
+  uint64_t scale = (uint64_t)constrain(config.brightness, 0, 255) * constrain(balance, 0, 255);
+  uint64_t full  = (uint64_t)65535 * 255 * 255;
+  for (int i = 0; i < 256; i++) {
+    uint32_t value = (config.gamma ? pgm_read_word(&gamma16[i]) : i * 257);
+    // without dithering the fraction is rounded off here already
+    if (config.dither) {
+      uint64_t fine = (value * scale * 255 * 256 + full / 2) / full;
+      fine = (fine < 255 * 256 ? fine : 255 * 256);
+      lut[c][i] = fine >> 8;
+      fraction[c][i] = fine;
+    }
+    else
+      lut[c][i] = (value * scale * 255 + full / 2) / full;
+  }
+  *scale16 = (scale * 65536 + 65025 / 2) / 65025;
+}
+
+// the fractions are in the pixel arena, the error starts over whenever they are written
+static void buildTables(void) {
+  if (config.dither) {
+    arenaClaim(ARENA_DITHER);
+    errorCount = 0;
+  }
+  buildChannel(R_OFFSET - 1, &scale16[0], config.red);
+  buildChannel(G_OFFSET - 1, &scale16[1], config.green);
+  buildChannel(B_OFFSET - 1, &scale16[2], config.blue);
+  identity = !config.gamma && config.brightness >= 255 && config.red >= 255 && config.green >= 255 && config.blue >= 255;
+  dither = config.dither && !identity;
+}
+
+void lutBuild(void) {
+  buildTables();
+  lutGeneration++;
+}
+
+bool lutDithering(void) {
+  return dither;
+}
+
+// the error starts with a pattern along the strip, so that neighbouring pixels do not step up in the same frame
+static bool resizeError(uint16_t count) {
+  if (count > MAX_PIXELS)
+    return false;
+  if (count != errorCount) {
+    errorCount = count;
+    for (uint16_t i = 0; i < 3 * errorCount; i++)
+      error[i] = i * 151;
+  }
+  return true;
+}
+
+void lutApply(uint8_t *frames, uint16_t count) {
+  if (identity)
+    return;
+  lutEncode(frames, frames, count);
+}
+
+void lutEncode(const uint8_t *frames, uint8_t *out, uint16_t count) {
+  if (identity) {
+    if (out != frames)
+      memcpy(out, frames, PIXEL_BYTES * count);
+    return;
+  }
+  // the fractions and the error are rebuilt if another mode used their memory in between
+  if (dither && !arenaClaim(ARENA_DITHER))
+    buildTables();
+  // the brightness byte is passed on as it is
+  if (!dither || !resizeError(count)) {
+    for (uint16_t i = 0; i < count; i++, frames += PIXEL_BYTES, out += PIXEL_BYTES) {
+      out[0] = frames[0];
+      out[1] = lut[0][frames[1]];
+      out[2] = lut[1][frames[2]];
+      out[3] = lut[2][frames[3]];
+    }
+    return;
+  }
+  // add the fraction to what is owed, a whole step is paid out in this frame
+  uint8_t *e = error;
+  for (uint16_t i = 0; i < count; i++, frames += PIXEL_BYTES, out += PIXEL_BYTES, e += 3) {
+    out[0] = frames[0];
+    for (uint8_t c = 0; c < 3; c++) {
+      uint8_t value = frames[1 + c];
+      uint16_t owed = e[c] + fraction[c][value];
+      out[1 + c] = lut[c][value] + (owed >> 8);
+      e[c] = owed;
+    }
+  }
+}
+
+// the gamma curve between its two nearest points
+static inline uint32_t gammaCurve(uint32_t value) {
+  uint32_t lo = pgm_read_word(&gamma16[value >> 8]);
+  uint32_t hi = (value >= 0xFF00 ? 65535 : pgm_read_word(&gamma16[(value >> 8) + 1]));
+  return lo + ((hi - lo) * (value & 0xFF) >> 8);
+}
+
+void lutApply16(uint16_t *rgb, uint16_t count) {
+  if (identity)
+    return;
+  if (config.gamma)
+    for (uint16_t i = 0; i < count; i++, rgb += 3) {
+      rgb[0] = gammaCurve(rgb[0]) * scale16[0] >> 16;
+      rgb[1] = gammaCurve(rgb[1]) * scale16[1] >> 16;
+      rgb[2] = gammaCurve(rgb[2]) * scale16[2] >> 16;
+    }
+  else
+    for (uint16_t i = 0; i < count; i++, rgb += 3) {
+      rgb[0] = rgb[0] * scale16[0] >> 16;
+      rgb[1] = rgb[1] * scale16[1] >> 16;
+      rgb[2] = rgb[2] * scale16[2] >> 16;
+    }
+}
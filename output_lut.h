@@ -0,0 +1,46 @@
+#ifndef _OUTPUT_LUT_H_
+#define _OUTPUT_LUT_H_
+
+#include <Arduino.h>
+
+/*
+  Output stage of the pixels. The modes compute linear values, just before
+  the frame is transmitted every subpixel is replaced through a table per
+  color that combines the gamma curve, the global brightness and the white
+  balance. The gamma curve itself is a 16-bit table in flash, the three 8-bit
+  tables in RAM are only rebuilt when the configuration changes. For 16-bit
+  output the gamma curve is interpolated and scaled directly.
+
+  config.gamma        0 for linear output, 1 for gamma 2.8
+  config.brightness   global brightness, 0-255
+  config.red/green/blue   white balance, the scale of each color, 0-255
+  config.dither       1 to dither the fractions of the corrected values
+
+  With dithering a second set of tables keeps 8 fractional bits, in the
+  pixel arena, see pixel_arena.h. Every subpixel has one byte with the
+  fraction it is still owed, and a whole step is sent whenever that
+  overflows, so a dim color that falls between two output levels is shown
+  as the right mix of both over a few frames. This only works while
+  frames keep being transmitted, so unchanged frames are not skipped then
+  and the loop shows the strip again on every tick.
+*/
+
+// rebuild the tables from the configuration
+void lutBuild(void);
+
+// correct the colors of count LED frames as in the strip buffer, in place
+void lutApply(uint8_t *frames, uint16_t count);
+
+// the same into the next frame of the output, see output_driver.h, the strip buffer is not changed
+void lutEncode(const uint8_t *frames, uint8_t *out, uint16_t count);
+
+// dithering is configured and the tables are not the identity
+bool lutDithering(void);
+
+// the same on 16-bit values, three per pixel in r, g, b order, see apa102.h
+void lutApply16(uint16_t *rgb, uint16_t count);
+
+// incremented by lutBuild, so that an unchanged frame is transmitted again with the new tables
+extern uint8_t lutGeneration;
+
+#endif
@@ -0,0 +1,28 @@
+#include "pixel_arena.h"
+#include "e131_input.h"
+#include "interpolate.h"
+
+PixelArena arena;
+
+// the host build has longer strips for the benchmark
+#ifndef HOST_BUILD
+static_assert(sizeof(PixelArena) + INPUT_FRAMES * FRAME_SLOTS + INTERPOLATE_SLOTS <= BUFFER_BUDGET,
+              "the pixel arena, the DMX frames and the blend are over their budget, lower MAX_PIXELS");
+#endif
+
+static uint8_t arenaUser = 0xFF;
+
+bool arenaClaim(uint8_t user) {
+  if (arenaUser == user)
+    return true;
+  arenaUser = user;
+  return false;
+}
+
+uint32_t heapMin = UINT32_MAX;
+
+void heapSample(void) {
+  uint32_t free = ESP.getFreeHeap();
+  if (free < heapMin)
+    heapMin = free;
+}
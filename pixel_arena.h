@@ -0,0 +1,65 @@
+#ifndef _PIXEL_ARENA_H_
+#define _PIXEL_ARENA_H_
+
+#include <Arduino.h>
+#include "dotstar_strip.h"
+
+/*
+  All buffers that grow with the number of pixels, sized at build time for
+  MAX_PIXELS. Changing config.pixels only changes the logical length, the
+  heap is never touched, so a running sketch cannot fragment it by
+  resizing the strip. A longer strip is cut off at MAX_PIXELS.
+
+  strip     the wire frame of the strip, see dotstar_strip.h
+  output    the front and back buffers of the output driver
+  shown     the LED frames that were transmitted last, see showPixels()
+  hdr       the 16-bit pixels of mode 13, see apa102.h
+  dither    the fractions of the output tables and those owed to every
+            subpixel, see output_lut.h
+
+  shown, hdr and dither share their memory. Unchanged frames are not
+  skipped in mode 13 or while dithering, and mode 13 is not dithered, so
+  only one of them is needed at a time. Each user calls arenaClaim()
+  before it reads what it left there.
+
+  The arena is about 18 bytes per pixel. Together with the DMX frames of
+  the input, about 12 bytes per pixel, and the blended channels of
+  interpolate.h it must fit in BUFFER_BUDGET, the rest of the RAM is for
+  the web server, JSON and the file system.
+  heapSample() keeps the lowest free heap that was seen.
+*/
+
+#ifndef MAX_PIXELS
+#define MAX_PIXELS 1020   // six universes of RGB pixels
+#endif
+
+#define BUFFER_BUDGET 32768   // bytes
+
+#define ARENA_SHOWN  0
+#define ARENA_HDR    1
+#define ARENA_DITHER 2
+
+struct PixelArena {
+  uint8_t strip[PIXEL_BYTES * MAX_PIXELS];
+  uint8_t output[2][PIXEL_BYTES * MAX_PIXELS];
+  union {
+    uint8_t shown[PIXEL_BYTES * MAX_PIXELS];
+    uint16_t hdr[3 * MAX_PIXELS];
+    struct {
+      uint8_t error[3 * MAX_PIXELS];
+      uint8_t fraction[3][256];
+    } dither;
+  };
+};
+
+extern PixelArena arena;
+
+// the shared buffers go to user, false if another user had them, i.e. what was left there is gone
+bool arenaClaim(uint8_t user);
+
+// remember the free heap if it is the lowest so far
+void heapSample(void);
+
+extern uint32_t heapMin;   // bytes, the lowest free heap since the start
+
+#endif
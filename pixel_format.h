@@ -0,0 +1,59 @@
+#ifndef _PIXEL_FORMAT_H_
+#define _PIXEL_FORMAT_H_
+
+#include <Arduino.h>
+#include "pixel_ops.h"
+
+/*
+  Pixel formats for the render kernels of the modes. Every mode is a template
+  on the format, so that the inner loops know at compile time whether the DMX
+  colors have a white channel and where red, green and blue go in the LED
+  frames of the strip buffer. The instantiation is selected once when the
+  configuration changes, see modeSelect() in mode_registry.h.
+
+  WHITE   1 if every color has a white channel in the DMX data (config.leds 4
+          with config.white), 0 for plain RGB
+  ORDER   color order of the strip buffer, as STRIP_ORDER
+
+  APA102 pixels have no white LED, so the white channel is added to red,
+  green and blue, saturating at full scale.
+*/
+
+extern DotStarStrip strip;
+
+template <uint8_t WHITE, uint8_t ORDER>
+struct PixelFormat {
+  static constexpr bool white = WHITE;
+  static constexpr uint8_t rOffset = 1 + ((ORDER >> 0) & 3);
+  static constexpr uint8_t gOffset = 1 + ((ORDER >> 2) & 3);
+  static constexpr uint8_t bOffset = 1 + ((ORDER >> 4) & 3);
+
+  // write the colors of the LED frame at p, values are 0-255
+  static inline void put(uint8_t *p, uint32_t r, uint32_t g, uint32_t b, uint32_t w = 0) {
+    if (WHITE) {
+      r = (r + w < 255 ? r + w : 255);
+      g = (g + w < 255 ? g + w : 255);
+      b = (b + w < 255 ? b + w : 255);
+    }
+    p[rOffset] = r;
+    p[gOffset] = g;
+    p[bOffset] = b;
+  }
+
+  // set count pixels starting at first to one color
+  static inline void fill(uint16_t first, uint16_t count, uint32_t r, uint32_t g, uint32_t b, uint32_t w = 0) {
+    if (first >= strip.numPixels() || count == 0)
+      return;
+    put(strip.getPixels() + PIXEL_BYTES * first, r, g, b, w);
+    repeatPixels(first, 1, count);
+  }
+};
+
+#define FORMAT_RGB   0
+#define FORMAT_RGBW  1
+#define FORMAT_COUNT 2
+
+typedef PixelFormat<0, STRIP_ORDER> FormatRGB;
+typedef PixelFormat<1, STRIP_ORDER> FormatRGBW;
+
+#endif
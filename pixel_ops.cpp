@@ -0,0 +1,93 @@
+#include "pixel_ops.h"
+#include "output_lut.h"
+#include "output_driver.h"
+#include "pixel_arena.h"
+
+extern DotStarStrip strip;
+
+// clip a range of pixels to the strip, returns the number of pixels that remain
+static uint16_t clip(uint16_t first, uint16_t count) {
+  uint16_t n = strip.numPixels();
+  if (first >= n)
+    return 0;
+  return (count < n - first ? count : n - first);
+}
+
+// fill total bytes with the pattern in the first period bytes, doubling the copy each time
+static void repeatBytes(uint8_t *p, size_t period, size_t total) {
+  size_t done = period;
+  while (done < total) {
+    size_t n = (done < total - done ? done : total - done);
+    memcpy(p + done, p, n);
+    done += n;
+  }
+}
+
+void fillPixels(uint16_t first, uint16_t count, uint8_t r, uint8_t g, uint8_t b) {
+  count = clip(first, count);
+  if (count == 0)
+    return;
+  // the first LED frame, brightness byte included, is doubled over the rest
+  uint8_t *p = strip.getPixels() + PIXEL_BYTES * first;
+  p[R_OFFSET] = r;
+  p[G_OFFSET] = g;
+  p[B_OFFSET] = b;
+  repeatBytes(p, PIXEL_BYTES, PIXEL_BYTES * count);
+}
+
+void copyPixels(uint16_t first, const uint8_t *rgb, uint16_t count) {
+  count = clip(first, count);
+  uint8_t *p = strip.getPixels() + PIXEL_BYTES * first;
+  for (uint16_t i = 0; i < count; i++, p += PIXEL_BYTES, rgb += 3) {
+    p[R_OFFSET] = rgb[0];
+    p[G_OFFSET] = rgb[1];
+    p[B_OFFSET] = rgb[2];
+  }
+}
+
+void repeatPixels(uint16_t first, uint16_t period, uint16_t count) {
+  count = clip(first, count);
+  if (period == 0 || count <= period)
+    return;
+  repeatBytes(strip.getPixels() + PIXEL_BYTES * first, PIXEL_BYTES * period, PIXEL_BYTES * count);
+}
+
+// copy of the last transmitted LED frames, the brightness bytes included
+static uint8_t *shown = arena.shown;
+static int32_t shownPixels = -1;      // nothing was transmitted yet
+static uint8_t shownGeneration = 0;
+static uint32_t tic_shown = 0;
+
+uint32_t showTransfers = 0;
+uint32_t showSkipped = 0;
+
+void showPixels(void) {
+  uint16_t n = strip.numPixels();
+  const uint8_t *pixels = strip.getPixels();
+  bool keepalive = (KEEPALIVE_INTERVAL > 0 && (millis() - tic_shown) >= KEEPALIVE_INTERVAL);
+
+  // dithered frames are always transmitted, the dither state takes the place of the copy then
+  if (lutDithering())
+    shownPixels = -1;
+  else {
+    if (!arenaClaim(ARENA_SHOWN))
+      shownPixels = -1;
+    if (n == shownPixels && lutGeneration == shownGeneration && !keepalive && !memcmp(shown, pixels, PIXEL_BYTES * n)) {
+      showSkipped++;
+      return;
+    }
+    shownPixels = n;
+    shownGeneration = lutGeneration;
+    memcpy(shown, pixels, PIXEL_BYTES * n);
+  }
+
+  // the corrected LED frames go into the next frame of the output driver, the modes continue from the linear values,
+  // with the identity tables this is a plain copy
+  uint8_t *frames = outputFrames(n);
+  if (!frames)
+    return;
+  lutEncode(pixels, frames, n);
+  outputSend();
+  showTransfers++;
+  tic_shown = millis();
+}
@@ -0,0 +1,46 @@
+#ifndef _PIXEL_OPS_H_
+#define _PIXEL_OPS_H_
+
+#include <Arduino.h>
+#include "dotstar_strip.h"
+
+/*
+  Bulk writes straight into the pixel buffer of the strip, for modes that
+  put the same color or the same pattern on many pixels. The buffer holds
+  the LED frames of the wire format, PIXEL_BYTES per pixel: the brightness
+  byte, then the colors in the order of STRIP_ORDER.
+*/
+
+#define STRIP_ORDER DOTSTAR_BRG   // color order of the strip, as passed to DotStarStrip
+
+// the byte of each color in an LED frame
+#define R_OFFSET (1 + ((STRIP_ORDER >> 0) & 3))
+#define G_OFFSET (1 + ((STRIP_ORDER >> 2) & 3))
+#define B_OFFSET (1 + ((STRIP_ORDER >> 4) & 3))
+
+// set count pixels starting at first to one color
+void fillPixels(uint16_t first, uint16_t count, uint8_t r, uint8_t g, uint8_t b);
+
+// set count pixels starting at first from consecutive r, g, b triplets
+void copyPixels(uint16_t first, const uint8_t *rgb, uint16_t count);
+
+// repeat the pattern of the period pixels starting at first, until count pixels are filled
+void repeatPixels(uint16_t first, uint16_t period, uint16_t count);
+
+/*
+  Replaces strip.show() in the modes. The pixels are compared with the last
+  transmitted ones and an unchanged frame is not clocked out again, unless
+  KEEPALIVE_INTERVAL has passed since the last transfer. The output tables
+  of output_lut.h are applied on the way out, into the next frame of the
+  output driver, see output_driver.h. The frame is still going out when the
+  call returns, a caller that blocks afterwards calls outputFlush().
+*/
+
+#define KEEPALIVE_INTERVAL 0   // ms, 0 to never repeat an unchanged frame
+
+extern uint32_t showTransfers;  // frames clocked out
+extern uint32_t showSkipped;    // frames that were unchanged
+
+void showPixels(void);
+
+#endif
@@ -1,8 +1,18 @@
 #include "setup_ota.h"
+#include "e131_stats.h"
+#include "pixel_ops.h"
+#include "mode_registry.h"
+#include "output_driver.h"
+#include "pixel_arena.h"
+#include "json_writer.h"
+#include "status_record.h"
+#include "log.h"
+#include "config_store.h"
 
 extern ESP8266WebServer server;
 extern Config config;
-extern int packetCounter;
+extern const char *version;
+extern uint32_t webDelay;
 
 /***************************************************************************/
 
@@ -28,9 +38,55 @@ static String getContentType(const String& path) {
 
 /***************************************************************************/
 
+// the web pages as packed by "make -C host data", see README.txt
+#define ASSET_COUNT 24
+
+struct Asset {
+  char path[32];      // SPIFFS names have at most 31 characters
+  uint32_t etag;      // CRC of the contents
+  bool gz;            // a gzip copy is next to the file
+};
+
+static Asset assets[ASSET_COUNT];
+static uint8_t assetCount = 0;
+
+void loadAssets() {
+  LOG_I(LOG_WEB, "loadAssets");
+  assetCount = 0;
+  File f = SPIFFS.open("/assets.txt", "r");
+  if (!f)
+    return;
+  // one line per file: path, CRC in hex, 1 if there is a gzip copy
+  char line[64];
+  while (assetCount < ASSET_COUNT && f.available()) {
+    size_t n = f.readBytesUntil('\n', line, sizeof(line) - 1);
+    line[n] = 0;
+    char *path = strtok(line, " ");
+    char *etag = strtok(NULL, " ");
+    char *gz = strtok(NULL, " \r");
+    if (!path || !etag || strlen(path) >= sizeof(assets[0].path))
+      continue;
+    Asset *a = &assets[assetCount++];
+    strcpy(a->path, path);
+    a->etag = strtoul(etag, NULL, 16);
+    a->gz = (gz && gz[0] == '1');
+  }
+  f.close();
+}
+
+static const Asset *findAsset(const char *path) {
+  for (uint8_t i = 0; i < assetCount; i++)
+    if (!strcmp(assets[i].path, path))
+      return &assets[i];
+  return NULL;
+}
+
+/***************************************************************************/
+
 
 bool initialConfig() {
   config.universe = 1;
+  config.universes = 1;
   config.offset = 0;
   config.pixels = 12;
   config.leds = 4;
@@ -41,44 +97,55 @@ bool initialConfig() {
   config.reverse = 0;
   config.speed = 8;
   config.position = 1;
+  config.interpolate = 0;
+  config.gamma = 1;
+  config.red = 255;
+  config.green = 255;
+  config.blue = 255;
+  config.dither = 0;
+  config.slice1 = 0;
+  config.slice2 = 0;
   return true;
 }
 
-bool loadConfig() {
-  Serial.println("loadConfig");
+// the settings of /config.json, as it is in the data folder or was written by an older firmware
+static bool importConfig() {
+  LOG_I(LOG_CONFIG, "importConfig");
 
   File configFile = SPIFFS.open("/config.json", "r");
   if (!configFile) {
-    Serial.println("Failed to open config file");
+    LOG_W(LOG_CONFIG, "Failed to open config file");
     return false;
   }
 
   size_t size = configFile.size();
   if (size > 1024) {
-    Serial.println("Config file size is too large");
+    LOG_E(LOG_CONFIG, "Config file size is too large");
     return false;
   }
 
-  Serial.println("set pointer");
-  std::unique_ptr<char[]> buf(new char[size]);
-  Serial.println("read bytes");
+  LOG_D(LOG_CONFIG, "set pointer");
+  std::unique_ptr<char[]> buf(new char[size + 1]);
+  LOG_D(LOG_CONFIG, "read bytes");
   configFile.readBytes(buf.get(), size);
-  Serial.println("close");
+  buf[size] = 0;
+  LOG_D(LOG_CONFIG, "close");
   configFile.close();
 
-  Serial.println("jsonBuffer");
-  StaticJsonBuffer<300> jsonBuffer;
-  Serial.println("parseObject");
+  LOG_D(LOG_CONFIG, "jsonBuffer");
+  StaticJsonBuffer<400> jsonBuffer;
+  LOG_D(LOG_CONFIG, "parseObject");
   JsonObject& root = jsonBuffer.parseObject(buf.get());
 
-  Serial.println("root.success");
+  LOG_D(LOG_CONFIG, "root.success");
   if (!root.success()) {
-    Serial.println("Failed to parse config file");
+    LOG_E(LOG_CONFIG, "Failed to parse config file");
     return false;
   }
 
-  Serial.println("JSON_TO_CONFIG universe");
+  LOG_D(LOG_CONFIG, "JSON_TO_CONFIG universe");
   JSON_TO_CONFIG(universe, "universe");
+  JSON_TO_CONFIG(universes, "universes");
   JSON_TO_CONFIG(offset, "offset");
   JSON_TO_CONFIG(pixels, "pixels");
   JSON_TO_CONFIG(leds, "leds");
@@ -89,39 +156,72 @@ bool loadConfig() {
   JSON_TO_CONFIG(reverse, "reverse");
   JSON_TO_CONFIG(speed, "speed");
   JSON_TO_CONFIG(position, "position");
+  JSON_TO_CONFIG(interpolate, "interpolate");
+  JSON_TO_CONFIG(gamma, "gamma");
+  JSON_TO_CONFIG(red, "red");
+  JSON_TO_CONFIG(green, "green");
+  JSON_TO_CONFIG(blue, "blue");
+  JSON_TO_CONFIG(dither, "dither");
+  JSON_TO_CONFIG(slice1, "slice1");
+  JSON_TO_CONFIG(slice2, "slice2");
 
-  Serial.println("loadConfig return");
+  LOG_D(LOG_CONFIG, "importConfig return");
   return true;
 }
 
-bool saveConfig() {
-  Serial.println("saveConfig");
-  StaticJsonBuffer<300> jsonBuffer;
-  JsonObject& root = jsonBuffer.createObject();
-
-  CONFIG_TO_JSON(universe, "universe");
-  CONFIG_TO_JSON(offset, "offset");
-  CONFIG_TO_JSON(pixels, "pixels");
-  CONFIG_TO_JSON(leds, "leds");
-  CONFIG_TO_JSON(white, "white");
-  CONFIG_TO_JSON(brightness, "brightness");
-  CONFIG_TO_JSON(hsv, "hsv");
-  CONFIG_TO_JSON(mode, "mode");
-  CONFIG_TO_JSON(reverse, "reverse");
-  CONFIG_TO_JSON(speed, "speed");
-  CONFIG_TO_JSON(position, "position");
-
-  File configFile = SPIFFS.open("/config.json", "w");
-  if (!configFile) {
-    Serial.println("Failed to open config file for writing");
-    return false;
-  }
-  else {
-    Serial.println("Writing to config file");
-    root.printTo(configFile);
-    configFile.close();
+bool loadConfig() {
+  LOG_I(LOG_CONFIG, "loadConfig");
+  if (configLoad(&config))
     return true;
-  }
+  // no binary record yet, or both are damaged: the JSON file is imported once
+  if (!importConfig())
+    return false;
+  saveConfig();
+  return true;
+}
+
+// the binary record is only written when something changed, see config_store.h
+bool saveConfig() {
+  return configStore(&config);
+}
+
+// both records are erased first, neither of them brings the old settings back at the next boot
+bool defaultConfig() {
+  configErase();
+  initialConfig();
+  return saveConfig();
+}
+
+// the configuration as JSON, which handleJSON() takes back
+void handleConfigExport() {
+  char buf[512];
+  JsonWriter json(buf, sizeof(buf));
+  json.beginObject();
+  CONFIG_TO_WRITER(universe, "universe");
+  CONFIG_TO_WRITER(universes, "universes");
+  CONFIG_TO_WRITER(offset, "offset");
+  CONFIG_TO_WRITER(pixels, "pixels");
+  CONFIG_TO_WRITER(leds, "leds");
+  CONFIG_TO_WRITER(white, "white");
+  CONFIG_TO_WRITER(brightness, "brightness");
+  CONFIG_TO_WRITER(hsv, "hsv");
+  CONFIG_TO_WRITER(mode, "mode");
+  CONFIG_TO_WRITER(reverse, "reverse");
+  CONFIG_TO_WRITER(speed, "speed");
+  CONFIG_TO_WRITER(position, "position");
+  CONFIG_TO_WRITER(interpolate, "interpolate");
+  CONFIG_TO_WRITER(gamma, "gamma");
+  CONFIG_TO_WRITER(red, "red");
+  CONFIG_TO_WRITER(green, "green");
+  CONFIG_TO_WRITER(blue, "blue");
+  CONFIG_TO_WRITER(dither, "dither");
+  CONFIG_TO_WRITER(slice1, "slice1");
+  CONFIG_TO_WRITER(slice2, "slice2");
+  json.endObject();
+  if (json.overflow())
+    server.send(500, "text/plain", "config does not fit");
+  else
+    server.send_P(200, "application/json", json.c_str(), json.length());
 }
 
 /***************************************************************************/
@@ -130,6 +230,7 @@ void handleUpdate1() {
   server.sendHeader("Connection", "close");
   server.sendHeader("Access-Control-Allow-Origin", "*");
   server.send(200, "text/plain", (Update.hasError()) ? "FAIL" : "OK");
+  logFlush();
   ESP.restart();
 }
 
@@ -138,7 +239,7 @@ void handleUpdate2() {
   if (upload.status == UPLOAD_FILE_START) {
     Serial.setDebugOutput(true);
     WiFiUDP::stopAll();
-    Serial.printf("Update: %s\n", upload.filename.c_str());
+    LOG_I(LOG_WEB, "Update: %s", upload.filename.c_str());
     uint32_t maxSketchSpace = (ESP.getFreeSketchSpace() - 0x1000) & 0xFFFFF000;
     if (!Update.begin(maxSketchSpace)) { //start with max available size
       Update.printError(Serial);
@@ -149,7 +250,7 @@ void handleUpdate2() {
     }
   } else if (upload.status == UPLOAD_FILE_END) {
     if (Update.end(true)) { //true to set the size to the current progress
-      Serial.printf("Update Success: %u\nRebooting...\n", upload.totalSize);
+      LOG_I(LOG_WEB, "Update Success: %u, rebooting", (unsigned)upload.totalSize);
     } else {
       Update.printError(Serial);
     }
@@ -159,7 +260,7 @@ void handleUpdate2() {
 }
 
 void handleDirList() {
-  Serial.println("handleDirList");
+  LOG_D(LOG_WEB, "handleDirList");
   String str = "";
   Dir dir = SPIFFS.openDir("/");
   while (dir.next()) {
@@ -171,9 +272,150 @@ void handleDirList() {
   server.send(200, "text/plain", str);
 }
 
+// send what the writer holds as the next piece of a response of unknown length
+static void sendPiece(JsonWriter &json) {
+  server.sendContent_P(json.c_str(), json.length());
+  json.rewind();
+}
+
+// the counters and one piece per universe, through a buffer on the stack
+void handleStats() {
+  char buf[256];
+  JsonWriter json(buf, sizeof(buf));
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "application/json", "");
+  json.beginObject();
+  json.add("uptime", (unsigned long)(millis() / 1000));
+  json.add("packets", (unsigned long)packetTotal);
+  json.add("frames", (unsigned long)frameTotal);
+  json.add("fps", statsFrameRate(), 1);
+  json.add("lost", (unsigned long)statsLost());
+  json.add("duplicates", (unsigned long)statsDuplicates());
+  json.add("reordered", (unsigned long)statsReordered());
+  json.add("skipped", (unsigned long)showSkipped);
+  json.add("output", (unsigned long)outputTime);
+  json.add("waits", (unsigned long)outputWaits);
+  json.beginArray("universes");
+  int universes = constrain(config.universes, 1, MAX_UNIVERSES);
+  for (int u = 0; u < universes; u++) {
+    const UniverseStats *s = &universeStats[u];
+    sendPiece(json);
+    json.beginObject();
+    json.add("universe", config.universe + u);
+    json.add("packets", (unsigned long)s->packets);
+    json.add("lost", (unsigned long)s->lost);
+    json.add("duplicates", (unsigned long)s->duplicates);
+    json.add("reordered", (unsigned long)s->reordered);
+    json.add("pps", statsPacketRate(u), 1);
+    json.add("interval", (long)s->interval);
+    json.beginArray("jitter");
+    for (int bin = 0; bin < JITTER_BINS; bin++)
+      json.add(NULL, (unsigned long)s->jitter[bin]);
+    json.endArray();
+    json.endObject();
+  }
+  json.endArray();
+  json.endObject();
+  if (json.overflow())
+    LOG_E(LOG_WEB, "stats do not fit");
+  sendPiece(json);
+  server.sendContent_P("", 0);
+}
+
+// the configuration and the counters, printed into a buffer on the stack
+void handleStatusJSON() {
+  char buf[1024];
+  JsonWriter json(buf, sizeof(buf));
+  heapSample();
+  json.beginObject();
+  CONFIG_TO_WRITER(universe, "universe");
+  CONFIG_TO_WRITER(universes, "universes");
+  CONFIG_TO_WRITER(offset, "offset");
+  CONFIG_TO_WRITER(pixels, "pixels");
+  CONFIG_TO_WRITER(leds, "leds");
+  CONFIG_TO_WRITER(white, "white");
+  CONFIG_TO_WRITER(brightness, "brightness");
+  CONFIG_TO_WRITER(hsv, "hsv");
+  CONFIG_TO_WRITER(mode, "mode");
+  CONFIG_TO_WRITER(reverse, "reverse");
+  CONFIG_TO_WRITER(speed, "speed");
+  CONFIG_TO_WRITER(position, "position");
+  CONFIG_TO_WRITER(interpolate, "interpolate");
+  CONFIG_TO_WRITER(gamma, "gamma");
+  CONFIG_TO_WRITER(red, "red");
+  CONFIG_TO_WRITER(green, "green");
+  CONFIG_TO_WRITER(blue, "blue");
+  CONFIG_TO_WRITER(dither, "dither");
+  CONFIG_TO_WRITER(slice1, "slice1");
+  CONFIG_TO_WRITER(slice2, "slice2");
+  json.add("version", version);
+  json.add("uptime", (unsigned long)(millis() / 1000));
+  json.add("packets", (unsigned long)packetTotal);
+  json.add("fps", statsFrameRate());
+  json.add("lost", (unsigned long)statsLost());
+  json.add("duplicates", (unsigned long)statsDuplicates());
+  json.add("reordered", (unsigned long)statsReordered());
+  json.add("skipped", (unsigned long)showSkipped);
+  json.add("output", (unsigned long)outputTime);
+  json.add("waits", (unsigned long)outputWaits);
+  json.add("maxpixels", MAX_PIXELS);
+  json.add("arena", (unsigned long)sizeof(arena));
+  json.add("heap", (unsigned long)ESP.getFreeHeap());
+  json.add("heapmin", (unsigned long)heapMin);
+  json.add("webdelay", (unsigned long)webDelay);
+  json.endObject();
+  if (json.overflow())
+    server.send(500, "text/plain", "status does not fit");
+  else
+    server.send_P(200, "application/json", json.c_str(), json.length());
+}
+
+void handleStatusBin() {
+  StatusRecord status;
+  heapSample();
+  statusRecord(&status);
+  server.send_P(200, "application/octet-stream", (const char *)&status, sizeof(status));
+}
+
+// one piece per mode, the channel names are copied out of the list one by one
+void handleModes() {
+  char buf[256], name[24];
+  JsonWriter json(buf, sizeof(buf));
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "application/json", "");
+  json.beginArray();
+  for (int m = 0; m < (int)MODE_COUNT; m++) {
+    const ModeInfo *info = modeInfo(m);
+    json.beginObject();
+    json.add("mode", m);
+    json.add("name", info->name);
+    json.add("animated", info->animated);
+    json.add("repeat", info->repeat == MODE_PER_PIXEL ? "pixel" : info->repeat == MODE_PER_SEGMENT ? "segment" : "once");
+    json.add("rgb", (int)info->rgb);
+    json.add("rgbw", (int)info->rgbw);
+    json.beginArray("channels");
+    for (const char *c = info->channels; *c; ) {
+      size_t n = strcspn(c, ",");
+      snprintf(name, sizeof(name), "%.*s", (int)n, c);
+      json.add(NULL, name);
+      c += n;
+      if (*c)
+        c++;
+    }
+    json.endArray();
+    json.endObject();
+    sendPiece(json);
+  }
+  json.endArray();
+  if (json.overflow())
+    LOG_E(LOG_WEB, "modes do not fit");
+  sendPiece(json);
+  server.sendContent_P("", 0);
+}
+
 void handleNotFound() {
-  Serial.println("handleNotFound");
-  if (SPIFFS.exists(server.uri())) {
+  LOG_D(LOG_WEB, "handleNotFound %s", server.uri().c_str());
+  if (SPIFFS.exists(server.uri()) || SPIFFS.exists(server.uri() + ".gz")) {
     handleStaticFile(server.uri());
   }
   else {
@@ -199,7 +441,7 @@ void handleRedirect(String filename) {
 }
 
 void handleRedirect(const char * filename) {
-  Serial.println("handleRedirect");
+  LOG_D(LOG_WEB, "handleRedirect %s", filename);
   server.sendHeader("Location", String(filename), true);
   server.send(302, "text/plain", "");
 }
@@ -210,49 +452,64 @@ void handleStaticFile(String filename) {
   handleStaticFile(buf);
 }
 
+// the file is streamed from SPIFFS as it is read, the gzip copy if the browser takes it,
+// a packed file that the browser already has is answered with 304 and no body
 void handleStaticFile(const char * filename) {
-  Serial.println("handleStaticFile");
-  File f = SPIFFS.open(filename, "r");
-  Serial.print("Opening file ");
-  Serial.print(filename);
+  const Asset *a = findAsset(filename);
+  bool gz;
+  if (a)
+    gz = a->gz && strstr(server.header("Accept-Encoding").c_str(), "gzip");
+  else
+    gz = !SPIFFS.exists(filename);
+
+  char etag[16];
+  if (a) {
+    snprintf(etag, sizeof(etag), "\"%08x%s\"", (unsigned)a->etag, gz ? "g" : "");
+    if (strstr(server.header("If-None-Match").c_str(), etag)) {
+      server.sendHeader("ETag", etag);
+      server.send(304);
+      return;
+    }
+  }
+
+  char path[40];
+  snprintf(path, sizeof(path), "%s%s", filename, gz ? ".gz" : "");
+  File f = SPIFFS.open(path, "r");
   if (!f) {
-    Serial.println("  FAILED");
+    LOG_W(LOG_WEB, "handleStaticFile %s failed", path);
     server.send(500, "text/html", "File not found");
-  } else {
-    Serial.println("  OK");
-    String content = f.readString();
-    f.close();
-    server.sendHeader("Connection", "close");
-    server.sendHeader("Access-Control-Allow-Origin", "*");
-    server.send(200, getContentType(String(filename)), content);
+    return;
   }
+  LOG_D(LOG_WEB, "handleStaticFile %s", path);
+  server.sendHeader("Access-Control-Allow-Origin", "*");
+  if (a) {
+    // the browser asks again every time, but only gets the file when it has changed
+    server.sendHeader("ETag", etag);
+    server.sendHeader("Cache-Control", "no-cache");
+    if (a->gz)
+      server.sendHeader("Vary", "Accept-Encoding");
+  }
+  // a .gz file goes out with Content-Encoding: gzip
+  server.streamFile(f, getContentType(String(filename)));
+  f.close();
 }
 
 void handleJSON() {
-  Serial.println("handleJSON");
-  String message = "HTTP Request\n\n";
-  message += "URI: ";
-  message += server.uri();
-  message += "\nMethod: ";
-  message += (server.method() == HTTP_GET) ? "GET" : "POST";
-  message += "\nArguments: ";
-  message += server.args();
-  message += "\n";
-  for (uint8_t i = 0; i < server.args(); i++) {
-    message += " " + server.argName(i) + ": " + server.arg(i) + "\n";
-  }
-  Serial.println(message);
+  LOG_I(LOG_WEB, "handleJSON %s %s, %d arguments", (server.method() == HTTP_PUT) ? "PUT" : "POST", server.uri().c_str(), server.args());
+  for (uint8_t i = 0; i < server.args(); i++)
+    LOG_D(LOG_WEB, " %s: %s", server.argName(i).c_str(), server.arg(i).c_str());
 
   // this gets called in response to either a PUT or a POST
   if (server.hasArg("plain")) {
     // parse it as JSON object
-    StaticJsonBuffer<300> jsonBuffer;
+    StaticJsonBuffer<400> jsonBuffer;
     JsonObject& root = jsonBuffer.parseObject(server.arg("plain"));
     if (!root.success()) {
       handleStaticFile("/reload_failed.html");
       return;
     }
     JSON_TO_CONFIG(universe, "universe");
+    JSON_TO_CONFIG(universes, "universes");
     JSON_TO_CONFIG(offset, "offset");
     JSON_TO_CONFIG(pixels, "pixels");
     JSON_TO_CONFIG(leds, "leds");
@@ -263,11 +520,20 @@ void handleJSON() {
     JSON_TO_CONFIG(reverse, "reverse");
     JSON_TO_CONFIG(speed, "speed");
     JSON_TO_CONFIG(position, "position");
+    JSON_TO_CONFIG(interpolate, "interpolate");
+    JSON_TO_CONFIG(gamma, "gamma");
+    JSON_TO_CONFIG(red, "red");
+    JSON_TO_CONFIG(green, "green");
+    JSON_TO_CONFIG(blue, "blue");
+    JSON_TO_CONFIG(dither, "dither");
+    JSON_TO_CONFIG(slice1, "slice1");
+    JSON_TO_CONFIG(slice2, "slice2");
     handleStaticFile("/reload_success.html");
   }
   else {
     // parse it as key1=val1&key2=val2&key3=val3
     KEYVAL_TO_CONFIG(universe, "universe");
+    KEYVAL_TO_CONFIG(universes, "universes");
     KEYVAL_TO_CONFIG(offset, "offset");
     KEYVAL_TO_CONFIG(pixels, "pixels");
     KEYVAL_TO_CONFIG(leds, "leds");
@@ -278,6 +544,14 @@ void handleJSON() {
     KEYVAL_TO_CONFIG(reverse, "reverse");
     KEYVAL_TO_CONFIG(speed, "speed");
     KEYVAL_TO_CONFIG(position, "position");
+    KEYVAL_TO_CONFIG(interpolate, "interpolate");
+    KEYVAL_TO_CONFIG(gamma, "gamma");
+    KEYVAL_TO_CONFIG(red, "red");
+    KEYVAL_TO_CONFIG(green, "green");
+    KEYVAL_TO_CONFIG(blue, "blue");
+    KEYVAL_TO_CONFIG(dither, "dither");
+    KEYVAL_TO_CONFIG(slice1, "slice1");
+    KEYVAL_TO_CONFIG(slice2, "slice2");
     handleStaticFile("/reload_success.html");
   }
   saveConfig();
@@ -9,12 +9,13 @@
 #include <FS.h>
 
 #define JSON_TO_CONFIG(x, y)   { if (root.containsKey(y)) { config.x = root[y]; } }
-#define CONFIG_TO_JSON(x, y)   { root[y] = config.x; }
+#define CONFIG_TO_WRITER(x, y) { json.add(y, config.x); }
 #define KEYVAL_TO_CONFIG(x, y) { if (server.hasArg(y))    { String str = server.arg(y); config.x = str.toInt(); } }
 
 
 struct Config {
   int universe;
+  int universes;
   int offset;
   int pixels;
   int leds;
@@ -25,15 +26,30 @@ struct Config {
   int reverse;
   int speed;
   int position;
+  int interpolate;
+  int gamma;
+  int red;
+  int green;
+  int blue;
+  int dither;
+  int slice1;
+  int slice2;
 };
 
 bool initialConfig(void);
 bool loadConfig(void);
 bool saveConfig(void);
+bool defaultConfig(void);
 
 void handleUpdate1(void);
 void handleUpdate2(void);
 void handleDirList(void);
+void handleStats(void);
+void handleModes(void);
+void handleStatusJSON(void);
+void handleStatusBin(void);
+void handleConfigExport(void);
+void loadAssets(void);
 void handleNotFound(void);
 void handleRedirect(String);
 void handleRedirect(const char *);
@@ -0,0 +1,32 @@
+#include "status_record.h"
+#include "setup_ota.h"
+#include "e131_stats.h"
+#include "pixel_ops.h"
+#include "output_driver.h"
+#include "pixel_arena.h"
+
+extern Config config;
+extern uint32_t webDelay;
+
+void statusRecord(StatusRecord *status) {
+  status->magic      = STATUS_MAGIC;
+  status->version    = STATUS_VERSION;
+  status->length     = sizeof(StatusRecord);
+  status->uptime     = millis() / 1000;
+  status->packets    = packetTotal;
+  status->frames     = frameTotal;
+  status->fps        = statsFrameRate() * 100 + 0.5;
+  status->universe   = config.universe;
+  status->lost       = statsLost();
+  status->duplicates = statsDuplicates();
+  status->reordered  = statsReordered();
+  status->skipped    = showSkipped;
+  status->output     = outputTime;
+  status->waits      = outputWaits;
+  status->heap       = ESP.getFreeHeap();
+  status->heapMin    = heapMin;
+  status->webDelay   = webDelay;
+  status->pixels     = config.pixels;
+  status->mode       = config.mode;
+  status->universes  = config.universes;
+}
@@ -0,0 +1,43 @@
+#ifndef _STATUS_RECORD_H_
+#define _STATUS_RECORD_H_
+
+#include <Arduino.h>
+
+/*
+  The counters of /json as one fixed record for /status.bin, so that a
+  monitor that polls many nodes does not have to parse JSON. The record is
+  little-endian, as it is in the memory of the ESP8266, without padding.
+  New fields are only ever appended: a poller checks magic and version and
+  reads at most length bytes.
+*/
+
+#define STATUS_MAGIC   0x5345   // "ES"
+#define STATUS_VERSION 1
+
+struct __attribute__((packed)) StatusRecord {
+  uint16_t magic;
+  uint8_t  version;
+  uint8_t  length;        // bytes in the record
+  uint32_t uptime;        // s
+  uint32_t packets;       // E1.31 packets for one of our universes
+  uint32_t frames;        // frames published
+  uint16_t fps;           // frames per second * 100
+  uint16_t universe;
+  uint32_t lost;
+  uint32_t duplicates;
+  uint32_t reordered;
+  uint32_t skipped;       // frames that were not transmitted because nothing changed
+  uint32_t output;        // us on the wire for the last frame
+  uint32_t waits;         // frames that waited for the previous one
+  uint32_t heap;          // bytes free
+  uint32_t heapMin;       // lowest free heap since the start
+  uint32_t webDelay;      // us, the longest a render waited for the web server
+  uint16_t pixels;
+  uint8_t  mode;
+  uint8_t  universes;
+};
+
+// the current values
+void statusRecord(StatusRecord *status);
+
+#endif